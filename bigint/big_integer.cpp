@@ -1,12 +1,19 @@
 #include "big_integer.h"
+#include "big_integer_kernels.h"
+#include "big_integer_arena.h"
+#include "big_integer_parallel.h"
 #include <stdexcept>
 #include <algorithm>
 #include <utility>
-#include <functional>
 #include <utility>
 #include <iostream>
 
-using uint128_t = unsigned int __attribute__((mode(TI)));
+namespace {
+	const big_integer::limb_t decimal_base = 10000000000000000000u;
+	const size_t decimal_base_digits = 19;
+	const size_t to_string_threshold = 32;
+	const size_t from_string_threshold = 64;
+}
 
 bool big_integer::positive() const {
 	return sign;
@@ -16,6 +23,10 @@ bool big_integer::is_zero() const {
 	return dig.size() == 1 && dig[0] == 0;
 }
 
+std::pmr::memory_resource *big_integer::resource() const {
+	return dig.resource();
+}
+
 big_integer abs(const big_integer &a) {
 	return a < 0 ? -a : a;
 }
@@ -24,14 +35,24 @@ big_integer::big_integer() : sign(true), dig({0u}) {}
 
 big_integer::big_integer(const big_integer &other) : sign(other.sign), dig(other.dig) {}
 
+big_integer::big_integer(big_integer &&other) noexcept : sign(other.sign), dig(std::move(other.dig)) {
+	other.sign = true;
+	other.dig.push_back(0u);
+}
+
 big_integer::big_integer(int a) {
 	sign = a >= 0;
-	dig = std::vector<uint32_t>({static_cast<uint32_t>(std::abs(static_cast<int64_t>(a)))});
+	dig = storage_t({static_cast<limb_t>(std::abs(static_cast<int64_t>(a)))});
 }
 
 big_integer::big_integer(uint32_t a) : sign(true), dig({a}) {}
 
-big_integer::big_integer(const std::string &str) : big_integer() {
+big_integer::big_integer(std::pmr::memory_resource *resource) : sign(true), dig(1, 0u, resource) {}
+
+big_integer::big_integer(big_integer const &other, std::pmr::memory_resource *resource)
+	: sign(other.sign), dig(other.dig, resource) {}
+
+big_integer::big_integer(std::string_view str) : big_integer() {
 	if (str.empty()) {
 		throw std::length_error("can not create big_int from empty string");
 	}
@@ -40,31 +61,88 @@ big_integer::big_integer(const std::string &str) : big_integer() {
 		throw std::runtime_error(std::string("digit expected, ") + str[0] + " found");
 	}
 
-	for (size_t i = isdigit(str[0]) ? 0 : 1; i < str.size();) {
-		uint32_t to_mult = 1;
-		uint32_t to_add = 0;
+	bool negative = str[0] == '-';
+
+	if (!isdigit(str[0])) {
+		str.remove_prefix(1);
+	}
+
+	auto wrong = std::find_if(str.begin(), str.end(), [](char c) { return !isdigit(c); });
+
+	if (wrong != str.end()) {
+		throw std::runtime_error(std::string("digit expected, ") + *wrong + " found");
+	}
+
+	kernels::scratch_buffer<limb_t> blocks((str.size() + decimal_base_digits - 1) / decimal_base_digits);
+
+	size_t const segment = 4096;
+
+	kernels::parallel_for((blocks.size() + segment - 1) / segment, blocks.size(), [&](size_t s) {
+		for (size_t i = s * segment; i < std::min(blocks.size(), (s + 1) * segment); i++) {
+			size_t end = str.size() - i * decimal_base_digits;
+			size_t begin = end > decimal_base_digits ? end - decimal_base_digits : 0;
 
-		for (size_t len = 9; i < str.size() && len > 0; i++, len--) {
-			if (!isdigit(str[i])) {
-				throw std::runtime_error(std::string("digit expected, ") + str[i] + " found");
+			for (size_t j = begin; j < end; j++) {
+				blocks[i] = 10 * blocks[i] + str[j] - '0';
 			}
+		}
+	});
+
+	if (blocks.size() > 0) {
+		std::vector<big_integer> powers(1, big_integer(true, {decimal_base}));
 
-			to_mult *= 10;
-			to_add = 10 * to_add + str[i] - '0';
+		while (blocks.size() > from_string_threshold && (size_t(1) << powers.size()) < blocks.size()) {
+			powers.push_back(powers.back() * powers.back());
 		}
 
-		*this *= to_mult;
-		*this += to_add;
+		*this = read_decimal(blocks.data(), blocks.size(), powers);
 	}
 
-	sign = str[0] != '-';
+	sign = !negative;
+	normalize();
+}
+
+// Value of count base 10^19 digits, least significant first. The lower
+// 2^k of them and the rest are converted independently, on separate
+// threads for long inputs, and merged with powers[k] = 10^(19 * 2^k).
+big_integer big_integer::read_decimal(limb_t const *blocks, size_t count, std::vector<big_integer> const &powers) {
+	if (count <= from_string_threshold) {
+		storage_t digits(1, blocks[count - 1]);
 
-	if (is_zero()) {
-		sign = true;
+		for (size_t i = count - 1; i > 0; i--) {
+			limb_t carry = kernels::mul_1(digits.data(), digits.data(), digits.size(), decimal_base);
+			carry += kernels::add(digits.data(), digits.data(), digits.size(), &blocks[i - 1], 1);
+
+			if (carry) {
+				digits.push_back(carry);
+			}
+		}
+
+		return big_integer(true, digits);
 	}
+
+	size_t level = 0;
+
+	while ((size_t(2) << level) < count) {
+		level++;
+	}
+
+	size_t half = size_t(1) << level;
+	big_integer high, low;
+
+	kernels::parallel_for(2, count, [&](size_t i) {
+		if (i == 0) {
+			high = read_decimal(blocks + half, count - half, powers);
+		} else {
+			low = read_decimal(blocks, half, powers);
+		}
+	});
+
+	high *= powers[level];
+	return high += low;
 }
 
-big_integer::big_integer(bool sign, std::vector<uint32_t> digits) : sign(sign), dig(std::move(digits)) {
+big_integer::big_integer(bool sign, storage_t digits) : sign(sign), dig(std::move(digits)) {
 	normalize();
 }
 
@@ -78,9 +156,26 @@ big_integer &big_integer::operator=(big_integer const &other) {
 	return *this;
 }
 
-bool big_integer::is_smaller(const big_integer &other, size_t other_size) {
+big_integer &big_integer::operator=(big_integer &&other) {
+	if (this == &other) {
+		return *this;
+	}
+	// both keep their resources, the digits are copied if those differ
+	sign = other.sign;
+	dig = std::move(other.dig);
+
+	// the source is left zero as after move construction, without holding
+	// on to the old digits
+	storage_t zero(1, 0u, other.dig.resource());
+	other.sign = true;
+	other.dig.swap(zero);
+
+	return *this;
+}
+
+bool big_integer::is_smaller(const big_integer &other, size_t other_size) const {
 	for (size_t i = 1; i <= dig.size(); i++) {
-		uint32_t other_dig = other_size - i < other.dig.size() ? other.dig[other_size - i] : 0u;
+		limb_t other_dig = other_size - i < other.dig.size() ? other.dig[other_size - i] : 0u;
 
 		if (dig[dig.size() - i] != other_dig) {
 			return dig[dig.size() - i] >= other_dig;
@@ -91,42 +186,17 @@ bool big_integer::is_smaller(const big_integer &other, size_t other_size) {
 }
 
 void big_integer::difference(const big_integer &other, size_t shift) {
-	bool take = false;
-
-	for (size_t k = 0; k + shift < size(); k++) {
-		int64_t diff = static_cast<int64_t>(dig[shift + k]);
-		diff -= static_cast<int64_t>(k < other.size() ? other[k] : 0);
-		diff -= static_cast<int64_t>(take);
-
-		take = diff < 0;
-		dig[shift + k] = static_cast<uint32_t>(diff);
-	}
-
-	if (!dig.back()) {
-		dig.pop_back();
-	}
+	kernels::sub(dig.data() + shift, dig.data() + shift, size() - shift, other.dig.data(), other.size());
 }
 
 int compare(const big_integer &a, const big_integer &b) {
-	if (a.size() > b.size()) {
+	if (a.positive() != b.positive()) {
 		return a.positive() ? +1 : -1;
-	} else if (a.size() < b.size()) {
-		return b.positive() ? -1 : +1;
-	} else {
-		if (a.positive() != b.positive()) {
-			return a.positive() ? +1 : -1;
-		}
-
-		for (size_t i = a.size() - 1; i + 1 > 0; i--) {
-			if (a[i] < b[i]) {
-				return a.positive() ? -1 : +1;
-			} else if (a[i] > b[i]) {
-				return a.positive() ? +1 : -1;
-			}
-		}
-
-		return 0;
 	}
+
+	int result = a.size() != b.size() ? (a.size() < b.size() ? -1 : +1)
+	                                  : kernels::compare(a.dig.data(), b.dig.data(), a.size());
+	return a.positive() ? result : -result;
 }
 
 bool operator==(const big_integer &a, const big_integer &b) {
@@ -154,7 +224,7 @@ bool operator>=(const big_integer &a, const big_integer &b) {
 }
 
 void big_integer::normalize() {
-	while (dig.size() > 1u && dig.back() == 0u) {
+	while (dig.size() > 1u && std::as_const(dig).back() == 0u) {
 		dig.pop_back();
 	}
 
@@ -169,16 +239,33 @@ big_integer big_integer::operator+() const {
 
 big_integer big_integer::operator-() const {
 	big_integer negative(*this);
+	return negative.negate();
+}
 
-	if (!negative.is_zero()) {
-		negative.sign = !negative.sign;
+big_integer &big_integer::negate() {
+	if (!is_zero()) {
+		sign = !sign;
 	}
 
-	return negative;
+	return *this;
 }
 
+// ~x is -(x + 1), one pass over the magnitude, which grows by one for x >= 0
+// and shrinks by one otherwise
 big_integer big_integer::operator~() const {
-	return -(*this) - 1;
+	limb_t const one = 1;
+	big_integer result(*this);
+
+	if (sign) {
+		result.dig.resize(size() + 1, 0u);
+		kernels::add(result.dig.data(), result.dig.data(), result.size(), &one, 1);
+	} else {
+		kernels::sub(result.dig.data(), result.dig.data(), size(), &one, 1);
+	}
+
+	result.sign = !sign;
+	result.normalize();
+	return result;
 }
 
 big_integer &big_integer::operator+=(big_integer const &rhs) {
@@ -189,17 +276,7 @@ big_integer &big_integer::operator+=(big_integer const &rhs) {
 	}
 
 	dig.resize(std::max(size(), rhs.size()) + 1, 0u);
-
-	uint32_t carry = 0;
-
-	for (size_t i = 0; i < rhs.size() || carry > 0; i++) {
-		uint64_t cur_dig = carry + static_cast<uint64_t>(dig[i]);
-		cur_dig += i < rhs.size() ? rhs[i] : 0u;
-
-		carry = cur_dig >> 32u;
-		dig[i] = cur_dig & UINT32_MAX;
-	}
-
+	kernels::add(dig.data(), dig.data(), size(), rhs.dig.data(), rhs.size());
 	normalize();
 
 	return *this;
@@ -228,225 +305,492 @@ big_integer &big_integer::operator-=(big_integer const &rhs) {
 }
 
 big_integer &big_integer::operator*=(big_integer const &rhs) {
-	dig.resize(dig.size() + rhs.dig.size());
+	storage_t product(size() + rhs.size(), 0u, dig.resource());
+
+	if (size() >= rhs.size()) {
+		kernels::mul(product.data(), std::as_const(dig).data(), size(), rhs.dig.data(), rhs.size());
+	} else {
+		kernels::mul(product.data(), rhs.dig.data(), rhs.size(), std::as_const(dig).data(), size());
+	}
+
 	sign = sign == rhs.sign;
+	dig.swap(product);
+	normalize();
+	return *this;
+}
 
-	for (size_t k = dig.size(); k > 0; k--) {
-		uint32_t carry = 0;
-		uint32_t cur_value = 0;
+big_integer &addmul(big_integer &r, big_integer const &a, big_integer const &b) {
+	return r.add_product(a, b, a.sign == b.sign);
+}
 
-		for (size_t i = k - 1, j = 0; j < std::min(k, rhs.dig.size()); i--, j++) {
-			uint64_t a_mul_b = static_cast<uint64_t>(dig[i]) * rhs[j];
-			a_mul_b += carry;
-			a_mul_b += cur_value;
+big_integer &submul(big_integer &r, big_integer const &a, big_integer const &b) {
+	return r.add_product(a, b, a.sign != b.sign);
+}
 
-			cur_value = a_mul_b & UINT32_MAX;
-			carry = a_mul_b >> 32u;
+// *this += |a * b| with the given sign
+big_integer &big_integer::add_product(big_integer const &a, big_integer const &b, bool positive) {
+	if (a.is_zero() || b.is_zero()) {
+		return *this;
+	} else if (&a == this || &b == this) {
+		big_integer copy = *this;
+		return add_product(&a == this ? copy : a, &b == this ? copy : b, positive);
+	}
 
-			for (size_t carry_pos = k; carry_pos < dig.size() && carry != 0; carry_pos++) {
-				uint64_t dig_with_carry = static_cast<uint64_t>(dig[carry_pos]) + carry;
-				dig[carry_pos] = dig_with_carry & UINT32_MAX;
-				carry = dig_with_carry >> 32u;
-			}
-		}
+	big_integer const &x = a.size() >= b.size() ? a : b;
+	big_integer const &y = a.size() >= b.size() ? b : a;
+	size_t n = x.size();
 
-		dig[k - 1] = cur_value;
+	if (y.size() > 1 || (sign != positive && !is_zero())) {
+		kernels::scratch_buffer<limb_t> product(n + y.size());
+		kernels::mul(product.data(), x.dig.data(), n, y.dig.data(), y.size());
+		add_magnitude(product.data(), product.size(), positive);
+		return *this;
 	}
 
+	sign = positive;
+	dig.resize(std::max(size(), n + 1) + 1, 0u);
+	limb_t *d = dig.data();
+	limb_t carry = kernels::addmul_1(d, x.dig.data(), n, y.dig[0]);
+	kernels::add(d + n, d + n, size() - n, &carry, 1);
 	normalize();
 	return *this;
 }
 
-std::pair<big_integer, uint32_t> big_integer::div_mod_short(uint32_t rhs) {
-	big_integer quotient;
-	quotient.dig.resize(size(), 0u);
-	uint64_t remainder = 0;
+// *this += p[0..n) with the given sign
+void big_integer::add_magnitude(limb_t const *p, size_t n, bool positive) {
+	while (n > 0 && p[n - 1] == 0) {
+		n--;
+	}
 
-	for (size_t i = dig.size(); i > 0; i--) {
-		remainder <<= 32u;
-		remainder += dig[i - 1];
-		uint32_t ratio = remainder / rhs;
-		remainder -= ratio * rhs;
-		quotient.dig[i - 1] = ratio;
+	if (n == 0) {
+		return;
 	}
 
-	quotient.normalize();
-	return std::make_pair(quotient, static_cast<uint32_t>(remainder));
-}
+	if (sign == positive || is_zero()) {
+		sign = positive;
+		dig.resize(std::max(size(), n) + 1, 0u);
+		kernels::add(dig.data(), dig.data(), size(), p, n);
+	} else if (size() > n || (size() == n && kernels::compare(std::as_const(dig).data(), p, n) >= 0)) {
+		kernels::sub(dig.data(), dig.data(), size(), p, n);
+	} else {
+		size_t m = size();
+		dig.resize(n, 0u);
+		kernels::sub(dig.data(), p, n, dig.data(), m);
+		sign = positive;
+	}
 
-std::pair<big_integer, big_integer> big_integer::div_mod_long(big_integer const &rhs) {
-	big_integer quotient(sign == rhs.sign, {});
-	quotient.dig.resize(dig.size() - rhs.dig.size() + 1);
-	big_integer rhs_abs = abs(rhs);
+	normalize();
+}
 
-	big_integer dividend(*this);
-	dig.push_back(0u);
-	size_t n = dig.size(), m = rhs.dig.size() + 1;
+big_integer &or_shifted(big_integer &r, big_integer const &a, uint32_t shift) {
+	if (!r.sign || !a.sign || &r == &a) {
+		return r |= a << shift;
+	} else if (a.is_zero()) {
+		return r;
+	}
 
-	uint64_t denominator = static_cast<uint64_t>(rhs_abs.dig.back()) << 32u;
-	denominator |= static_cast<uint64_t>(rhs_abs.dig[rhs_abs.dig.size() - 2]);
+	size_t limbs = shift / kernels::limb_bits;
+	uint32_t cnt = shift % kernels::limb_bits;
+	size_t n = a.size();
 
-	for (size_t i = m - 1, j = quotient.dig.size() - 1; i != n; i++, j--) {
-		uint128_t numerator = static_cast<uint128_t>(dig.back()) << 64u;
-		numerator |= static_cast<uint128_t>(dig[dig.size() - 2]) << 32u;
-		numerator |= static_cast<uint128_t>(dig[dig.size() - 3]);
+	r.dig.resize(std::max(r.size(), n + limbs + 1), 0u);
+	big_integer::limb_t *d = r.dig.data() + limbs;
+	big_integer::limb_t const *s = a.dig.data();
 
-		uint32_t ratio = static_cast<uint32_t>(numerator / denominator);
-		big_integer to_sub = rhs_abs * ratio;
+	if (cnt == 0) {
+		for (size_t i = 0; i < n; i++) {
+			d[i] |= s[i];
+		}
+	} else {
+		d[0] |= s[0] << cnt;
 
-		if (!(*this).is_smaller(to_sub, m)) {
-			ratio--;
-			to_sub -= rhs_abs;
+		for (size_t i = 1; i < n; i++) {
+			d[i] |= (s[i] << cnt) | (s[i - 1] >> (kernels::limb_bits - cnt));
 		}
 
-		quotient.dig[j] = ratio;
-		(*this).difference(to_sub, dig.size() - m);
+		d[n] |= s[n - 1] >> (kernels::limb_bits - cnt);
 	}
 
-	normalize();
+	r.normalize();
+	return r;
+}
+
+std::pair<big_integer, big_integer::limb_t> big_integer::div_mod_short(limb_t rhs) const {
+	big_integer quotient;
+	quotient.dig.resize(size(), 0u);
+	limb_t remainder = kernels::div_1(quotient.dig.data(), dig.data(), size(), rhs);
+
 	quotient.normalize();
+	return std::make_pair(quotient, remainder);
+}
+
+std::pair<big_integer, big_integer> big_integer::div_mod_long(big_integer const &rhs) const {
+	size_t n = size(), m = rhs.size();
+	uint32_t norm = __builtin_clzll(rhs.dig.back());
 
-	return std::make_pair(quotient, *this);
+	storage_t quotient(n - m + 1);
+	storage_t remainder(n + 1);
+	kernels::scratch_buffer<limb_t> divisor(norm > 0 ? m : 0);
+	limb_t const *v = rhs.dig.data();
+
+	// shift both operands so that the highest bit of the divisor is set
+	if (norm > 0) {
+		kernels::lshift(divisor.data(), v, m, norm);
+		v = divisor.data();
+		remainder[n] = kernels::lshift(remainder.data(), dig.data(), n, norm);
+	} else {
+		std::copy(dig.begin(), dig.end(), remainder.begin());
+	}
+
+	kernels::div_qr(quotient.data(), remainder.data(), n + 1, v, m);
+
+	if (norm > 0) {
+		kernels::rshift(remainder.data(), remainder.data(), m, norm);
+	}
+
+	remainder.resize(m);
+	return std::make_pair(big_integer(sign == rhs.sign, std::move(quotient)), big_integer(sign, std::move(remainder)));
 }
 
-big_integer &big_integer::operator/=(big_integer const &rhs) {
+big_integer square(big_integer const &a) {
+	big_integer::storage_t r(2 * a.size(), 0u, a.resource());
+	kernels::sqr(r.data(), std::as_const(a.dig).data(), a.size());
+	return big_integer(true, std::move(r));
+}
+
+big_integer pow(big_integer const &base, uint64_t exp) {
+	big_integer result = 1;
+
+	for (uint64_t bit = exp > 0 ? uint64_t(1) << (63 - __builtin_clzll(exp)) : 0; bit > 0; bit >>= 1u) {
+		result = square(result);
+
+		if (exp & bit) {
+			result *= base;
+		}
+	}
+
+	return result;
+}
+
+std::pair<big_integer, big_integer> big_integer::div_mod(big_integer const &rhs) const {
 	if (rhs.is_zero()) {
 		throw std::range_error("division by zero");
 	} else if (rhs.size() > size() || !this->is_smaller(rhs, size())) {
-		return *this = 0;
+		return std::make_pair(big_integer(), *this);
 	} else if (rhs.size() == 1) {
-		return *this = sign == rhs.sign ? div_mod_short(rhs[0]).first : -div_mod_short(rhs[0]).first;
+		std::pair<big_integer, limb_t> short_result = div_mod_short(rhs[0]);
+
+		if (sign != rhs.sign) {
+			short_result.first.negate();
+		}
+
+		return std::make_pair(std::move(short_result.first), big_integer(sign, {short_result.second}));
 	} else {
-		return *this = div_mod_long(rhs).first;
+		return div_mod_long(rhs);
 	}
 }
 
+std::pair<big_integer, big_integer> divmod(const big_integer &a, const big_integer &b) {
+	return a.div_mod(b);
+}
+
+big_integer &big_integer::operator/=(big_integer const &rhs) {
+	return *this = div_mod(rhs).first;
+}
+
 big_integer &big_integer::operator%=(big_integer const &rhs) {
-	if (rhs.is_zero()) {
-		throw std::range_error("division by zero");
-	} else if (rhs.size() == 1) {
-		return *this = sign ? big_integer(div_mod_short(rhs[0]).second) : -big_integer(div_mod_short(rhs[0]).second);
-	} else {
-		return *this = *this - *this / rhs * rhs;
-	}
+	return *this = div_mod(rhs).second;
 }
 
 big_integer operator+(big_integer a, const big_integer &b) {
-	return a += b;
+	a += b;
+	return a;
+}
+
+big_integer operator+(const big_integer &a, big_integer &&b) {
+	b += a;
+	return std::move(b);
+}
+
+big_integer operator+(big_integer &&a, big_integer &&b) {
+	if (a.size() >= b.size()) {
+		a += b;
+		return std::move(a);
+	} else {
+		b += a;
+		return std::move(b);
+	}
 }
 
 big_integer operator-(big_integer a, const big_integer &b) {
-	return a -= b;
+	a -= b;
+	return a;
+}
+
+big_integer operator-(const big_integer &a, big_integer &&b) {
+	b -= a;
+	return std::move(b.negate());
+}
+
+big_integer operator-(big_integer &&a, big_integer &&b) {
+	if (a.size() >= b.size()) {
+		a -= b;
+		return std::move(a);
+	} else {
+		b -= a;
+		return std::move(b.negate());
+	}
 }
 
 big_integer operator*(big_integer a, const big_integer &b) {
-	return a *= b;
+	a *= b;
+	return a;
+}
+
+big_integer operator*(const big_integer &a, big_integer &&b) {
+	b *= a;
+	return std::move(b);
+}
+
+big_integer operator*(big_integer &&a, big_integer &&b) {
+	if (a.size() >= b.size()) {
+		a *= b;
+		return std::move(a);
+	} else {
+		b *= a;
+		return std::move(b);
+	}
 }
 
 big_integer operator/(big_integer a, const big_integer &b) {
-	return a /= b;
+	a /= b;
+	return a;
 }
 
 big_integer operator%(big_integer a, const big_integer &b) {
-	return a %= b;
+	a %= b;
+	return a;
 }
 
-void big_integer::transform_to_compl2(big_integer &a, size_t new_size) {
-	if (!a.sign) {
-		++a;
-		a.dig.resize(new_size, 0u);
+namespace {
+	using limb_t = big_integer::limb_t;
+
+	// turns the limbs of a magnitude into its two's complement one at a
+	// time, ~x + 1 with the carry passed on to the next limb; an involution,
+	// so the same pass turns a negative result back into a magnitude
+	struct compl2_limbs {
+		limb_t mask;
+		limb_t carry;
+
+		explicit compl2_limbs(bool negative) : mask(0 - limb_t(negative)), carry(negative) {}
 
-		for (uint32_t &x : a.dig) {
-			x = ~x;
+		limb_t operator()(limb_t x) {
+			limb_t result = (x ^ mask) + carry;
+			carry = result < carry;
+			return result;
+		}
+	};
+
+	limb_t apply(kernels::bit_op op, limb_t a, limb_t b) {
+		switch (op) {
+			case kernels::bit_op::bit_and:
+				return a & b;
+			case kernels::bit_op::bit_or:
+				return a | b;
+			default:
+				return a ^ b;
 		}
-	} else {
-		a.dig.resize(new_size, 0u);
 	}
 }
 
+big_integer &big_integer::apply_bitwise(big_integer const &rhs, kernels::bit_op op) {
+	if (this == &rhs) {
+		return apply_bitwise(big_integer(rhs), op);
+	}
+
+	size_t m = rhs.size();
+	bool result_sign = !apply(op, !sign, !rhs.sign);
+
+	dig.resize(std::max(size(), m), 0u);
+
+	limb_t *d = dig.data();
+	limb_t const *r = rhs.dig.data();
+	compl2_limbs a(!sign), b(!rhs.sign), c(!result_sign);
+	size_t i = 0;
+
+	// the carries die out at the lowest nonzero limbs, after that the two's
+	// complement is a plain mask and the rest goes in bulk
+	for (; i < size() && (a.carry | b.carry | c.carry); i++) {
+		d[i] = c(apply(op, a(d[i]), b(i < m ? r[i] : 0)));
+	}
+
+	if (i < m) {
+		kernels::bitwise_n(d + i, d + i, r + i, m - i, op, a.mask, b.mask, c.mask);
+		i = m;
+	}
+
+	// past the end of rhs every limb is combined with its sign extension,
+	// which either fixes the result or copies (maybe complements) this
+	limb_t low = c.mask ^ apply(op, 0, b.mask), high = c.mask ^ apply(op, ~limb_t(0), b.mask);
+
+	if (low == high) {
+		std::fill(d + i, d + size(), low);
+	} else if ((a.mask ^ low) != 0) {
+		kernels::com(d + i, d + i, size() - i);
+	}
+
+	// the sign extension of a negative result is all ones, which leaves
+	// only the carry in the next limb of its magnitude
+	if (c.carry) {
+		dig.push_back(1);
+	}
+
+	sign = result_sign;
+	normalize();
+	return *this;
+}
+
 big_integer &big_integer::operator&=(big_integer const &rhs) {
-	return *this = bit_function_applier(*this, rhs, std::bit_and<uint32_t>());
+	return apply_bitwise(rhs, kernels::bit_op::bit_and);
 }
 
 big_integer &big_integer::operator|=(big_integer const &rhs) {
-	return *this = bit_function_applier(*this, rhs, std::bit_or<uint32_t>());
+	return apply_bitwise(rhs, kernels::bit_op::bit_or);
 }
 
 big_integer &big_integer::operator^=(big_integer const &rhs) {
-	return *this = bit_function_applier(*this, rhs, std::bit_xor<uint32_t>());
+	return apply_bitwise(rhs, kernels::bit_op::bit_xor);
 }
 
-big_integer big_integer::bit_shift(ptrdiff_t shift) {
-	big_integer shifted(sign, dig);
-	sign = true;
-
-	if (shift > 0) {
-		shifted.dig.resize(shifted.size() + shift / (32 - 1) + 2);
+big_integer &big_integer::operator<<=(uint32_t rhs) {
+	if (is_zero()) {
+		return *this;
 	}
 
-	transform_to_compl2(*this, size());
+	size_t limbs = rhs / kernels::limb_bits;
+	uint32_t cnt = rhs % kernels::limb_bits;
+	size_t n = size();
 
-	for (size_t i = 0; i < shifted.size(); i++) {
-		ptrdiff_t start_bit = i * 32 - shift;
-		ptrdiff_t end_bit = (i + 1) * 32 - 1 - shift;
-		ptrdiff_t start_block = start_bit / 32u;
-		ptrdiff_t end_block = end_bit / 32u;
+	dig.resize(n + limbs + 1);
+	limb_t *d = dig.data();
 
-		uint32_t cnt = (32 - shift % 32) % 32;
-		uint32_t left_block, right_block;
+	// both copies go from the top, so the ranges may overlap
+	if (cnt > 0) {
+		d[n + limbs] = kernels::lshift(d + limbs, d, n, cnt);
+	} else {
+		std::copy_backward(d, d + n, d + n + limbs);
+		d[n + limbs] = 0;
+	}
 
-		if ((start_bit < 0 && shift >= 0) || start_block >= static_cast<ptrdiff_t>(dig.size())) {
-			left_block = 0;
-		} else {
-			left_block = dig[start_block];
-		}
+	std::fill(d, d + limbs, 0);
+	normalize();
+	return *this;
+}
 
-		if ((end_bit < 0 && shift >= 0) || end_block >= static_cast<ptrdiff_t>(dig.size())) {
-			right_block = 0;
-		} else {
-			right_block = dig[end_block];
-		}
+// rounds towards minus infinity, like a shift of the two's complement
+big_integer &big_integer::operator>>=(uint32_t rhs) {
+	size_t limbs = rhs / kernels::limb_bits;
+	uint32_t cnt = rhs % kernels::limb_bits;
+	size_t n = size();
+
+	if (limbs >= n) {
+		return *this = sign ? 0 : -1;
+	}
+
+	limb_t const *low = std::as_const(dig).data();
+	bool inexact = !sign && (std::any_of(low, low + limbs, [](limb_t x) { return x != 0; })
+			|| (low[limbs] & ((limb_t(1) << cnt) - 1)) != 0);
 
-		left_block >>= cnt;
-		right_block &= (1U << cnt) - 1U;
+	limb_t *d = dig.data();
 
-		shifted[i] = (cnt ? (right_block << (32u - cnt)) : 0) + left_block;
+	if (cnt > 0) {
+		kernels::rshift(d, d + limbs, n - limbs, cnt);
+	} else {
+		std::copy(d + limbs, d + n, d);
 	}
 
-	if (shift < 0 && !shifted.sign) {
-		--shifted;
+	dig.resize(n - limbs);
+
+	if (inexact) {
+		limb_t const one = 1;
+
+		if (kernels::add(d, d, n - limbs, &one, 1)) {
+			dig.push_back(1);
+		}
 	}
 
-	shifted.normalize();
-	return shifted;
+	normalize();
+	return *this;
 }
 
-big_integer &big_integer::operator<<=(uint32_t rhs) {
-	return *this = bit_shift(rhs);
+big_integer operator&(big_integer a, const big_integer &b) {
+	a &= b;
+	return a;
 }
 
-big_integer &big_integer::operator>>=(uint32_t rhs) {
-	return *this = bit_shift(-static_cast<ptrdiff_t>(rhs));
+big_integer operator&(const big_integer &a, big_integer &&b) {
+	b &= a;
+	return std::move(b);
 }
 
-big_integer operator&(big_integer a, const big_integer &b) {
-	return a &= b;
+big_integer operator&(big_integer &&a, big_integer &&b) {
+	if (a.size() >= b.size()) {
+		a &= b;
+		return std::move(a);
+	} else {
+		b &= a;
+		return std::move(b);
+	}
 }
 
 big_integer operator|(big_integer a, const big_integer &b) {
-	return a |= b;
+	a |= b;
+	return a;
+}
+
+big_integer operator|(const big_integer &a, big_integer &&b) {
+	b |= a;
+	return std::move(b);
+}
+
+big_integer operator|(big_integer &&a, big_integer &&b) {
+	if (a.size() >= b.size()) {
+		a |= b;
+		return std::move(a);
+	} else {
+		b |= a;
+		return std::move(b);
+	}
 }
 
 big_integer operator^(big_integer a, const big_integer &b) {
-	return a ^= b;
+	a ^= b;
+	return a;
+}
+
+big_integer operator^(const big_integer &a, big_integer &&b) {
+	b ^= a;
+	return std::move(b);
+}
+
+big_integer operator^(big_integer &&a, big_integer &&b) {
+	if (a.size() >= b.size()) {
+		a ^= b;
+		return std::move(a);
+	} else {
+		b ^= a;
+		return std::move(b);
+	}
 }
 
 big_integer operator<<(big_integer a, uint32_t b) {
-	return a <<= b;
+	a <<= b;
+	return a;
 }
 
 big_integer operator>>(big_integer a, uint32_t b) {
-	return a >>= b;
+	a >>= b;
+	return a;
 }
 
 big_integer &big_integer::operator++() {
@@ -469,30 +813,78 @@ big_integer big_integer::operator--(int) {
 	return copy;
 }
 
+namespace {
+	void write_decimal_basecase(big_integer::storage_t dig, char *first, char *last) {
+		size_t n = dig.size();
+
+		while (last != first) {
+			while (n > 0 && dig[n - 1] == 0) {
+				n--;
+			}
+
+			big_integer::limb_t chunk = n > 0 ? kernels::div_1(dig.data(), dig.data(), n, decimal_base) : 0;
+
+			for (size_t i = 0; i < decimal_base_digits && last != first; i++) {
+				*--last = static_cast<char>('0' + chunk % 10);
+				chunk /= 10;
+			}
+		}
+	}
+}
+
+// Writes exactly last - first digits of a, padding with leading zeros.
+// For level > 0 the range must be 19 * 2^level digits long. The halves of
+// long numbers fill their disjoint parts of the range on separate threads.
+void big_integer::write_decimal(big_integer a, std::vector<big_integer> const &powers, size_t level, char *first, char *last) {
+	if (level == 0 || a.size() <= to_string_threshold) {
+		write_decimal_basecase(a.dig, first, last);
+		return;
+	}
+
+	big_integer const &power = powers[level - 1];
+	char *middle = last - (decimal_base_digits << (level - 1));
+
+	if (a.size() < power.size() || !a.is_smaller(power, a.size())) {
+		std::fill(first, middle, '0');
+		write_decimal(a, powers, level - 1, middle, last);
+	} else {
+		std::pair<big_integer, big_integer> div_and_mod = a.div_mod_long(power);
+
+		kernels::parallel_for(2, a.size(), [&](size_t i) {
+			if (i == 0) {
+				write_decimal(div_and_mod.first, powers, level - 1, first, middle);
+			} else {
+				write_decimal(div_and_mod.second, powers, level - 1, middle, last);
+			}
+		});
+	}
+}
+
 std::string to_string(big_integer a) {
-	std::string result;
-	std::string sign = a.positive() ? "" : "-";
+	bool negative = !a.positive();
+	a.sign = true;
 
-	a = abs(a);
-	size_t needZero = 0;
+	std::vector<big_integer> powers(1, big_integer(true, {decimal_base}));
 
-	const uint32_t dig_remainder = 1000000000;
-	const uint32_t dig_count = 9;
+	while (a.size() > to_string_threshold && powers.back() <= a) {
+		powers.push_back(powers.back() * powers.back());
+	}
 
-	do {
-		auto div_and_mod = a.div_mod_short(dig_remainder);
-		std::string d = std::to_string(div_and_mod.second);
-		std::string t = std::string(needZero, '0');
-		needZero = dig_count - d.size();
-		d += t;
-		std::reverse(d.begin(), d.end());
-		result += d;
-		a = div_and_mod.first;
-	} while (a != 0);
+	size_t level = powers.size() - 1;
+	size_t length = a.size() > to_string_threshold
+		? decimal_base_digits << level
+		: a.size() * (kernels::limb_bits * 5 / 16);
 
-	result += sign;
+	std::string result(length, '0');
+	big_integer::write_decimal(a, powers, level, &result[0], &result[0] + length);
+
+	size_t leading_zeros = std::min(result.find_first_not_of('0'), length - 1);
+	result.erase(0, leading_zeros);
+
+	if (negative) {
+		result.insert(result.begin(), '-');
+	}
 
-	std::reverse(result.begin(), result.end());
 	return result;
 }
 
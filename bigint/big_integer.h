@@ -1,18 +1,37 @@
 #ifndef BIG_INTEGER_H
 #define BIG_INTEGER_H
 
+#include <cstddef>
+#include <cstdint>
+#include <memory_resource>
 #include <vector>
 #include <string>
+#include <string_view>
+#include <utility>
+#include "big_integer_kernels.h"
+#include "small_storage.h"
 
 struct big_integer {
+	using limb_t = kernels::limb_t;
+	using storage_t = small_storage<limb_t, 2>;
+
 	big_integer();
 	big_integer(const big_integer &other);
+	big_integer(big_integer &&other) noexcept;
 	big_integer(int a);
-	explicit big_integer(const std::string &str);
+	explicit big_integer(std::string_view str);
 	big_integer(uint32_t a);
 	~big_integer() = default;
 
+	// Zero, with digits allocated from resource for as long as the number
+	// lives, whatever is assigned to it. Other numbers, copies included
+	// unless given a resource, use operator new.
+	explicit big_integer(std::pmr::memory_resource *resource);
+	big_integer(big_integer const &other, std::pmr::memory_resource *resource);
+
+	// copies when other allocates from a different resource
 	big_integer &operator=(big_integer const &other);
+	big_integer &operator=(big_integer &&other);
 
 	big_integer &operator+=(big_integer const &rhs);
 	big_integer &operator-=(big_integer const &rhs);
@@ -54,27 +73,59 @@ struct big_integer {
 	friend big_integer operator|(big_integer a, const big_integer &b);
 	friend big_integer operator^(big_integer a, const big_integer &b);
 
+	friend big_integer operator+(const big_integer &a, big_integer &&b);
+	friend big_integer operator-(const big_integer &a, big_integer &&b);
+	friend big_integer operator*(const big_integer &a, big_integer &&b);
+	friend big_integer operator&(const big_integer &a, big_integer &&b);
+	friend big_integer operator|(const big_integer &a, big_integer &&b);
+	friend big_integer operator^(const big_integer &a, big_integer &&b);
+
+	friend big_integer operator+(big_integer &&a, big_integer &&b);
+	friend big_integer operator-(big_integer &&a, big_integer &&b);
+	friend big_integer operator*(big_integer &&a, big_integer &&b);
+	friend big_integer operator&(big_integer &&a, big_integer &&b);
+	friend big_integer operator|(big_integer &&a, big_integer &&b);
+	friend big_integer operator^(big_integer &&a, big_integer &&b);
+
 	friend big_integer operator<<(big_integer a, uint32_t b);
 	friend big_integer operator>>(big_integer a, uint32_t b);
 
+	// quotient rounded towards zero and remainder with the sign of a
+	friend std::pair<big_integer, big_integer> divmod(const big_integer &a, const big_integer &b);
+
+	// r += a * b and r -= a * b, the product is never materialized as a
+	// big_integer and a single limb factor is folded in one pass
+	friend big_integer &addmul(big_integer &r, big_integer const &a, big_integer const &b);
+	friend big_integer &submul(big_integer &r, big_integer const &a, big_integer const &b);
+
+	// r |= a << shift, in one pass when both are non-negative
+	friend big_integer &or_shifted(big_integer &r, big_integer const &a, uint32_t shift);
+
 	friend std::string to_string(big_integer a);
 
+	// a * a through the squaring kernels, in the resource of a
+	friend big_integer square(big_integer const &a);
+
 	bool positive() const;
 	bool is_zero() const;
+	std::pmr::memory_resource *resource() const;
 
  private:
-	big_integer(bool sign, std::vector<uint32_t> digits);
+	friend struct big_integer_modulus;
+	friend struct big_integer_montgomery;
+	friend big_integer powmod(big_integer const &base, big_integer const &exp, big_integer const &mod);
+
+	big_integer(bool sign, storage_t digits);
 	friend int compare(const big_integer &a, const big_integer &b);
 
-	bool is_smaller(const big_integer &other, size_t other_size);
+	bool is_smaller(const big_integer &other, size_t other_size) const;
 	void difference(const big_integer &other, size_t shift);
-	big_integer bit_shift(ptrdiff_t shift);
 
-	uint32_t operator[](size_t index) const {
+	limb_t operator[](size_t index) const {
 		return dig[index];
 	}
 
-	uint32_t &operator[](size_t index) {
+	limb_t &operator[](size_t index) {
 		return dig[index];
 	}
 
@@ -83,45 +134,27 @@ struct big_integer {
 	}
 
 	void normalize();
-	static void transform_to_compl2(big_integer &a, size_t new_size);
-
-	template<class BitFunction>
-	friend big_integer bit_function_applier
-			(big_integer lhs,
-			 big_integer rhs,
-			 BitFunction const &bit_function) {
-		size_t result_len = std::max(lhs.size(), rhs.size()) + 1;
-
-		transform_to_compl2(lhs, result_len);
-		transform_to_compl2(rhs, result_len);
-
-		std::vector<uint32_t> result_num(result_len);
-		bool result_sign = !bit_function(!lhs.sign, !rhs.sign);
+	big_integer &negate();
 
-		for (size_t i = 0; i < result_len; i++) {
-			uint32_t a = i < lhs.size() ? lhs[i] : 0;
-			uint32_t b = i < rhs.size() ? rhs[i] : 0;
-			uint32_t c = bit_function(a, b);
+	big_integer &add_product(big_integer const &a, big_integer const &b, bool positive);
+	void add_magnitude(limb_t const *p, size_t n, bool positive);
 
-			if (!result_sign) {
-				c = ~c;
-			}
+	big_integer &apply_bitwise(big_integer const &rhs, kernels::bit_op op);
 
-			result_num[i] = c;
-		}
+	std::pair<big_integer, big_integer> div_mod(big_integer const &rhs) const;
+	std::pair<big_integer, limb_t> div_mod_short(limb_t rhs) const;
+	std::pair<big_integer, big_integer> div_mod_long(big_integer const &rhs) const;
 
-		big_integer result = big_integer(result_sign, result_num);
-
-		return result_sign ? result : --result;
-	}
-
-	std::pair<big_integer, uint32_t> div_mod_short(uint32_t rhs);
-	std::pair<big_integer, big_integer> div_mod_long(big_integer const &rhs);
+	static big_integer read_decimal(limb_t const *blocks, size_t count, std::vector<big_integer> const &powers);
+	static void write_decimal(big_integer a, std::vector<big_integer> const &powers, size_t level, char *first, char *last);
 
 	bool sign;
-	std::vector<uint32_t> dig;
+	storage_t dig;
 };
 
+big_integer square(big_integer const &a);
+big_integer pow(big_integer const &base, uint64_t exp);
+
 std::ostream &operator<<(std::ostream &s, const big_integer &a);
 
 #endif // BIG_INTEGER_H
\ No newline at end of file
@@ -0,0 +1,76 @@
+#include "big_integer_arena.h"
+#include <cstdint>
+
+namespace kernels {
+	namespace {
+		const size_t alignment = 64;
+		const size_t first_chunk_size = size_t(64) << 10u;
+
+		thread_local scratch_arena *active = nullptr;
+	}
+
+	void *scratch_arena::allocate(size_t bytes) {
+		for (;;) {
+			if (current < chunks.size()) {
+				uintptr_t base = reinterpret_cast<uintptr_t>(chunks[current].data.get());
+				uintptr_t begin = (base + offset + alignment - 1) & ~(alignment - 1);
+
+				if (begin + bytes <= base + chunks[current].size) {
+					offset = begin + bytes - base;
+					return reinterpret_cast<void *>(begin);
+				}
+
+				// the following chunk is reused when it is large enough,
+				// otherwise it and the rest make way for a larger one
+				if (current + 1 < chunks.size() && chunks[current + 1].size >= bytes + alignment) {
+					current++;
+					offset = 0;
+					continue;
+				}
+
+				chunks.erase(chunks.begin() + current + 1, chunks.end());
+			}
+
+			size_t size = std::max(bytes + alignment, chunks.empty() ? first_chunk_size : 2 * chunks.back().size);
+			chunks.push_back({std::unique_ptr<unsigned char[]>(new unsigned char[size]), size});
+			current = chunks.size() - 1;
+			offset = 0;
+		}
+	}
+
+	void scratch_arena::rewind(marker m) {
+		current = m.chunk;
+		offset = m.offset;
+
+		if (current == 0 && offset == 0 && capacity() > retained_limit) {
+			chunks.clear();
+		}
+	}
+
+	size_t scratch_arena::capacity() const {
+		size_t result = 0;
+
+		for (chunk const &c : chunks) {
+			result += c.size;
+		}
+
+		return result;
+	}
+
+	scratch_arena &current_arena() {
+		if (active != nullptr) {
+			return *active;
+		}
+
+		thread_local scratch_arena fallback;
+		return fallback;
+	}
+
+	scoped_arena::scoped_arena(scratch_arena &arena) : previous(active) {
+		active = &arena;
+	}
+
+	scoped_arena::~scoped_arena() {
+		active = previous;
+	}
+}
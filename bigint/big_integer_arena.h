@@ -0,0 +1,125 @@
+#ifndef BIG_INTEGER_ARENA_H
+#define BIG_INTEGER_ARENA_H
+
+#include <algorithm>
+#include <cstddef>
+#include <memory>
+#include <type_traits>
+#include <vector>
+
+// Temporaries of the algorithms come from a bump allocator instead of the
+// heap. Every thread has a default arena which keeps its memory between
+// operations, so repeated arithmetic on numbers of similar size stops
+// allocating for scratch space once the arena has grown.
+namespace kernels {
+	class scratch_arena {
+	public:
+		// Position to rewind to, everything allocated after it is released.
+		struct marker {
+			size_t chunk;
+			size_t offset;
+		};
+
+		scratch_arena() = default;
+		scratch_arena(scratch_arena const &) = delete;
+		scratch_arena &operator=(scratch_arena const &) = delete;
+
+		// at least bytes bytes aligned to 64
+		void *allocate(size_t bytes);
+
+		marker mark() const {
+			return {current, offset};
+		}
+
+		void rewind(marker m);
+
+		// bytes held, allocated or not
+		size_t capacity() const;
+
+		// Memory an empty arena holds on to, above it every chunk is given
+		// back once everything is released.
+		static const size_t retained_limit = size_t(64) << 20u;
+
+	private:
+		struct chunk {
+			std::unique_ptr<unsigned char[]> data;
+			size_t size;
+		};
+
+		std::vector<chunk> chunks;
+		size_t current = 0;
+		size_t offset = 0;
+	};
+
+	// The arena temporaries of the calling thread come from: the innermost
+	// live scoped_arena, otherwise the thread's default one. Work handed to
+	// other threads uses theirs.
+	scratch_arena &current_arena();
+
+	// Makes arena the current one of the calling thread for its lifetime.
+	// Scopes nest and must be destroyed in reverse order.
+	class scoped_arena {
+	public:
+		explicit scoped_arena(scratch_arena &arena);
+		~scoped_arena();
+
+		scoped_arena(scoped_arena const &) = delete;
+		scoped_arena &operator=(scoped_arena const &) = delete;
+
+	private:
+		scratch_arena *previous;
+	};
+
+	// Zero-filled array of n elements from the current arena. Buffers are
+	// released in reverse order of creation, which locals guarantee.
+	template<typename T>
+	class scratch_buffer {
+		static_assert(std::is_trivially_copyable<T>::value, "scratch_buffer holds trivially copyable elements only");
+
+	public:
+		explicit scratch_buffer(size_t n)
+			: arena(current_arena()), start(arena.mark()),
+			  first(static_cast<T *>(arena.allocate(n * sizeof(T)))), count(n) {
+			std::fill(first, first + count, T());
+		}
+
+		~scratch_buffer() {
+			arena.rewind(start);
+		}
+
+		scratch_buffer(scratch_buffer const &) = delete;
+		scratch_buffer &operator=(scratch_buffer const &) = delete;
+
+		T *data() {
+			return first;
+		}
+
+		T const *data() const {
+			return first;
+		}
+
+		T *begin() {
+			return first;
+		}
+
+		T *end() {
+			return first + count;
+		}
+
+		T &operator[](size_t i) {
+			return first[i];
+		}
+
+		size_t size() const {
+			return count;
+		}
+
+	private:
+		scratch_arena &arena;
+		scratch_arena::marker start;
+		T *first;
+		size_t count;
+	};
+}
+
+#endif // BIG_INTEGER_ARENA_H
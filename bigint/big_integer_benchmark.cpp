@@ -0,0 +1,189 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "big_integer.h"
+#include "big_integer_gmp.h"
+
+// Times the operators of big_integer and big_integer_gmp side by side on
+// operands from 1 to 2^20 limbs. Every case is repeated until it has run for
+// at least min_time seconds, the ratio column is big_integer time over gmp
+// time.
+//
+//   big_integer_benchmark [--filter=<substring>] [--max_limbs=<n>] [--min_time=<seconds>]
+
+namespace {
+  char const* filter = "";
+  size_t max_limbs = size_t(1) << 20;
+  double min_time = 0.2;
+
+  template <typename T>
+  void do_not_optimize(T const& value) {
+    asm volatile("" : : "r"(&value) : "memory");
+  }
+
+  // nanoseconds per call, the number of calls grows until the total is long
+  // enough to trust
+  template <typename F>
+  double measure(F const& f) {
+    using clock = std::chrono::steady_clock;
+    size_t iterations = 1;
+
+    for (;;) {
+      auto start = clock::now();
+      for (size_t i = 0; i != iterations; ++i) {
+        f();
+      }
+      double elapsed = std::chrono::duration<double>(clock::now() - start).count();
+
+      if (elapsed >= min_time) {
+        return elapsed * 1e9 / iterations;
+      }
+
+      double estimate = elapsed > 0 ? min_time / elapsed * 1.4 : 10;
+      iterations = static_cast<size_t>(iterations * std::min(std::max(estimate, 2.0), 100.0));
+    }
+  }
+
+  // the same number for both libraries, put together from 16-bit pieces
+  // since that is all their int constructors are good for
+  template <typename T>
+  T from_limbs(uint64_t const* limbs, size_t n) {
+    if (n == 1) {
+      T result = 0;
+      for (int piece = 3; piece >= 0; --piece) {
+        result <<= 16;
+        result |= T(static_cast<int>((limbs[0] >> (16 * piece)) & 0xffff));
+      }
+      return result;
+    }
+
+    size_t half = n / 2;
+    return (from_limbs<T>(limbs + half, n - half) << static_cast<int>(64 * half)) | from_limbs<T>(limbs, half);
+  }
+
+  // a and b have the given number of limbs, wide has twice as many and is
+  // the dividend, so quotients are about as long as the divisor
+  struct operands {
+    explicit operands(size_t limbs) {
+      std::mt19937_64 rng(limbs);
+      generate(a, ga, limbs, rng);
+      generate(b, gb, limbs, rng);
+      generate(wide, gwide, 2 * limbs, rng);
+      a_str = to_string(ga);
+    }
+
+    big_integer a, b, wide;
+    big_integer_gmp ga, gb, gwide;
+    std::string a_str;
+
+   private:
+    static void generate(big_integer& x, big_integer_gmp& gx, size_t limbs, std::mt19937_64& rng) {
+      std::vector<uint64_t> data(limbs);
+      for (uint64_t& limb : data) {
+        limb = rng();
+      }
+      data.back() |= uint64_t(1) << 63;
+
+      x = from_limbs<big_integer>(data.data(), limbs);
+      gx = from_limbs<big_integer_gmp>(data.data(), limbs);
+      if (rng() & 1) {
+        x = -x;
+        gx = -gx;
+      }
+    }
+  };
+
+  struct benchmark_case {
+    char const* name;
+    void (*ours)(operands const& o);
+    void (*gmp)(operands const& o);
+  };
+
+  // not a multiple of the limb size, so every limb is rewritten
+  uint32_t const shift = 37;
+
+  benchmark_case const cases[] = {
+    {"add", [](operands const& o) { do_not_optimize(o.a + o.b); },
+            [](operands const& o) { do_not_optimize(o.ga + o.gb); }},
+    {"sub", [](operands const& o) { do_not_optimize(o.a - o.b); },
+            [](operands const& o) { do_not_optimize(o.ga - o.gb); }},
+    {"mul", [](operands const& o) { do_not_optimize(o.a * o.b); },
+            [](operands const& o) { do_not_optimize(o.ga * o.gb); }},
+    {"sqr", [](operands const& o) { do_not_optimize(o.a * o.a); },
+            [](operands const& o) { do_not_optimize(o.ga * o.ga); }},
+    {"div", [](operands const& o) { do_not_optimize(o.wide / o.b); },
+            [](operands const& o) { do_not_optimize(o.gwide / o.gb); }},
+    {"mod", [](operands const& o) { do_not_optimize(o.wide % o.b); },
+            [](operands const& o) { do_not_optimize(o.gwide % o.gb); }},
+    {"and", [](operands const& o) { do_not_optimize(o.a & o.b); },
+            [](operands const& o) { do_not_optimize(o.ga & o.gb); }},
+    {"or", [](operands const& o) { do_not_optimize(o.a | o.b); },
+           [](operands const& o) { do_not_optimize(o.ga | o.gb); }},
+    {"xor", [](operands const& o) { do_not_optimize(o.a ^ o.b); },
+            [](operands const& o) { do_not_optimize(o.ga ^ o.gb); }},
+    {"not", [](operands const& o) { do_not_optimize(~o.a); },
+            [](operands const& o) { do_not_optimize(~o.ga); }},
+    {"shl", [](operands const& o) { do_not_optimize(o.a << shift); },
+            [](operands const& o) { do_not_optimize(o.ga << static_cast<int>(shift)); }},
+    {"shr", [](operands const& o) { do_not_optimize(o.a >> shift); },
+            [](operands const& o) { do_not_optimize(o.ga >> static_cast<int>(shift)); }},
+    {"compare", [](operands const& o) { do_not_optimize(o.a < o.b); },
+                [](operands const& o) { do_not_optimize(o.ga < o.gb); }},
+    {"to_string", [](operands const& o) { do_not_optimize(to_string(o.a)); },
+                  [](operands const& o) { do_not_optimize(to_string(o.ga)); }},
+    {"from_string", [](operands const& o) { do_not_optimize(big_integer(o.a_str)); },
+                    [](operands const& o) { do_not_optimize(big_integer_gmp(o.a_str)); }},
+  };
+
+  bool selected(benchmark_case const& c) {
+    return std::strstr(c.name, filter) != nullptr;
+  }
+
+  bool parse_flag(char const* arg, char const* name, char const*& value) {
+    size_t length = std::strlen(name);
+    if (std::strncmp(arg, name, length) != 0 || arg[length] != '=') {
+      return false;
+    }
+    value = arg + length + 1;
+    return true;
+  }
+}
+
+int main(int argc, char** argv) {
+  for (int i = 1; i < argc; ++i) {
+    char const* value;
+    if (parse_flag(argv[i], "--filter", value)) {
+      filter = value;
+    } else if (parse_flag(argv[i], "--max_limbs", value)) {
+      max_limbs = std::strtoull(value, nullptr, 10);
+    } else if (parse_flag(argv[i], "--min_time", value)) {
+      min_time = std::strtod(value, nullptr);
+    } else {
+      std::fprintf(stderr, "usage: %s [--filter=<substring>] [--max_limbs=<n>] [--min_time=<seconds>]\n", argv[0]);
+      return 1;
+    }
+  }
+
+  std::printf("%-12s %10s %16s %16s %8s\n", "operation", "limbs", "big_integer", "gmp", "ratio");
+
+  for (size_t limbs = 1; limbs <= max_limbs; limbs *= 4) {
+    operands const o(limbs);
+
+    for (benchmark_case const& c : cases) {
+      if (!selected(c)) {
+        continue;
+      }
+
+      double ours = measure([&] { c.ours(o); });
+      double gmp = measure([&] { c.gmp(o); });
+      std::printf("%-12s %10zu %13.0f ns %13.0f ns %8.2f\n", c.name, limbs, ours, gmp, ours / gmp);
+      std::fflush(stdout);
+    }
+  }
+}
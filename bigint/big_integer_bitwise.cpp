@@ -0,0 +1,174 @@
+#include "big_integer_dispatch.h"
+
+#if defined(__x86_64__)
+#include <immintrin.h>
+#endif
+
+// Limb-wise logic and comparison. Both are bound by memory bandwidth on long
+// operands, so besides the plain loops there are AVX2 and AVX-512 versions.
+namespace kernels {
+	namespace {
+		template<bit_op OP>
+		limb_t apply(limb_t a, limb_t b) {
+			if constexpr (OP == bit_op::bit_and) {
+				return a & b;
+			} else if constexpr (OP == bit_op::bit_or) {
+				return a | b;
+			} else {
+				return a ^ b;
+			}
+		}
+
+		template<bit_op OP>
+		void bitwise_generic(limb_t *r, limb_t const *a, limb_t const *b, size_t n,
+		                     limb_t mask_a, limb_t mask_b, limb_t mask_r) {
+			for (size_t i = 0; i < n; i++) {
+				r[i] = mask_r ^ apply<OP>(a[i] ^ mask_a, b[i] ^ mask_b);
+			}
+		}
+
+		int compare_generic(limb_t const *a, limb_t const *b, size_t n) {
+			for (size_t i = n; i > 0; i--) {
+				if (a[i - 1] != b[i - 1]) {
+					return a[i - 1] < b[i - 1] ? -1 : +1;
+				}
+			}
+
+			return 0;
+		}
+
+#if defined(__x86_64__)
+		template<bit_op OP>
+		__attribute__((target("avx2")))
+		void bitwise_avx2(limb_t *r, limb_t const *a, limb_t const *b, size_t n,
+		                  limb_t mask_a, limb_t mask_b, limb_t mask_r) {
+			__m256i const va = _mm256_set1_epi64x(static_cast<long long>(mask_a));
+			__m256i const vb = _mm256_set1_epi64x(static_cast<long long>(mask_b));
+			__m256i const vr = _mm256_set1_epi64x(static_cast<long long>(mask_r));
+			size_t i = 0;
+
+			for (; i + 4 <= n; i += 4) {
+				__m256i x = _mm256_loadu_si256(reinterpret_cast<__m256i const *>(a + i));
+				__m256i y = _mm256_loadu_si256(reinterpret_cast<__m256i const *>(b + i));
+				__m256i p = x ^ va, q = y ^ vb;
+				__m256i z = vr ^ (OP == bit_op::bit_and ? p & q : OP == bit_op::bit_or ? p | q : p ^ q);
+				_mm256_storeu_si256(reinterpret_cast<__m256i *>(r + i), z);
+			}
+
+			bitwise_generic<OP>(r + i, a + i, b + i, n - i, mask_a, mask_b, mask_r);
+		}
+
+		template<bit_op OP>
+		__attribute__((target("avx512f")))
+		void bitwise_avx512(limb_t *r, limb_t const *a, limb_t const *b, size_t n,
+		                    limb_t mask_a, limb_t mask_b, limb_t mask_r) {
+			__m512i const va = _mm512_set1_epi64(static_cast<long long>(mask_a));
+			__m512i const vb = _mm512_set1_epi64(static_cast<long long>(mask_b));
+			__m512i const vr = _mm512_set1_epi64(static_cast<long long>(mask_r));
+			size_t i = 0;
+
+			for (; i + 8 <= n; i += 8) {
+				__m512i x = _mm512_loadu_si512(a + i);
+				__m512i y = _mm512_loadu_si512(b + i);
+				__m512i p = x ^ va, q = y ^ vb;
+				__m512i z = vr ^ (OP == bit_op::bit_and ? p & q : OP == bit_op::bit_or ? p | q : p ^ q);
+				_mm512_storeu_si512(r + i, z);
+			}
+
+			if (i < n) {
+				__mmask8 tail = static_cast<__mmask8>((1u << (n - i)) - 1);
+				__m512i x = _mm512_maskz_loadu_epi64(tail, a + i);
+				__m512i y = _mm512_maskz_loadu_epi64(tail, b + i);
+				__m512i p = x ^ va, q = y ^ vb;
+				__m512i z = vr ^ (OP == bit_op::bit_and ? p & q : OP == bit_op::bit_or ? p | q : p ^ q);
+				_mm512_mask_storeu_epi64(r + i, tail, z);
+			}
+		}
+
+		// both vector versions only look for the highest block that differs
+		// and leave the ordering of its limbs to compare_generic
+		__attribute__((target("avx2")))
+		int compare_avx2(limb_t const *a, limb_t const *b, size_t n) {
+			for (; n >= 4; n -= 4) {
+				__m256i x = _mm256_loadu_si256(reinterpret_cast<__m256i const *>(a + n - 4));
+				__m256i y = _mm256_loadu_si256(reinterpret_cast<__m256i const *>(b + n - 4));
+				__m256i diff = x ^ y;
+
+				if (!_mm256_testz_si256(diff, diff)) {
+					return compare_generic(a + n - 4, b + n - 4, 4);
+				}
+			}
+
+			return compare_generic(a, b, n);
+		}
+
+		__attribute__((target("avx512f")))
+		int compare_avx512(limb_t const *a, limb_t const *b, size_t n) {
+			for (; n >= 8; n -= 8) {
+				__m512i x = _mm512_loadu_si512(a + n - 8);
+				__m512i y = _mm512_loadu_si512(b + n - 8);
+
+				if (_mm512_cmpneq_epu64_mask(x, y)) {
+					return compare_generic(a + n - 8, b + n - 8, 8);
+				}
+			}
+
+			return compare_generic(a, b, n);
+		}
+#endif
+
+		using bitwise_loop = void (*)(limb_t *, limb_t const *, limb_t const *, size_t, limb_t, limb_t, limb_t);
+	}
+
+	namespace generic {
+		int compare(limb_t const *a, limb_t const *b, size_t n) {
+			return compare_generic(a, b, n);
+		}
+
+		void bitwise_n(limb_t *r, limb_t const *a, limb_t const *b, size_t n, bit_op op,
+		               limb_t mask_a, limb_t mask_b, limb_t mask_r) {
+			static bitwise_loop const loops[] = {
+					bitwise_generic<bit_op::bit_and>, bitwise_generic<bit_op::bit_or>, bitwise_generic<bit_op::bit_xor>
+			};
+
+			loops[static_cast<int>(op)](r, a, b, n, mask_a, mask_b, mask_r);
+		}
+	}
+
+#if defined(__x86_64__)
+	namespace avx2 {
+		int compare(limb_t const *a, limb_t const *b, size_t n) {
+			return compare_avx2(a, b, n);
+		}
+
+		void bitwise_n(limb_t *r, limb_t const *a, limb_t const *b, size_t n, bit_op op,
+		               limb_t mask_a, limb_t mask_b, limb_t mask_r) {
+			static bitwise_loop const loops[] = {
+					bitwise_avx2<bit_op::bit_and>, bitwise_avx2<bit_op::bit_or>, bitwise_avx2<bit_op::bit_xor>
+			};
+
+			loops[static_cast<int>(op)](r, a, b, n, mask_a, mask_b, mask_r);
+		}
+	}
+
+	namespace avx512 {
+		int compare(limb_t const *a, limb_t const *b, size_t n) {
+			return compare_avx512(a, b, n);
+		}
+
+		void bitwise_n(limb_t *r, limb_t const *a, limb_t const *b, size_t n, bit_op op,
+		               limb_t mask_a, limb_t mask_b, limb_t mask_r) {
+			static bitwise_loop const loops[] = {
+					bitwise_avx512<bit_op::bit_and>, bitwise_avx512<bit_op::bit_or>, bitwise_avx512<bit_op::bit_xor>
+			};
+
+			loops[static_cast<int>(op)](r, a, b, n, mask_a, mask_b, mask_r);
+		}
+	}
+
+#endif
+
+	void com(limb_t *r, limb_t const *a, size_t n) {
+		bitwise_n(r, a, a, n, bit_op::bit_and, ~limb_t(0), ~limb_t(0), 0);
+	}
+}
@@ -0,0 +1,317 @@
+#include "big_integer_dispatch.h"
+
+// Carry chains over whole limb arrays. The portable versions go through
+// dlimb_t, on x86-64 addition and subtraction are adc/sbb loops and the
+// multiply-accumulate family uses mulx with two independent carry chains
+// (adcx on CF, adox on OF) where the processor has BMI2 and ADX.
+//
+// The assembly loops handle four limbs per iteration, the n % 4 lowest limbs
+// are done by the portable code first and their carry is fed into the loop.
+// Loop control sticks to lea and jrcxz, which leave the flags alone.
+namespace kernels {
+	namespace generic {
+		limb_t add_n(limb_t *r, limb_t const *a, limb_t const *b, size_t n) {
+			limb_t carry = 0;
+
+			for (size_t i = 0; i < n; i++) {
+				dlimb_t sum = static_cast<dlimb_t>(a[i]) + b[i] + carry;
+				r[i] = static_cast<limb_t>(sum);
+				carry = static_cast<limb_t>(sum >> limb_bits);
+			}
+
+			return carry;
+		}
+
+		limb_t sub_n(limb_t *r, limb_t const *a, limb_t const *b, size_t n) {
+			limb_t borrow = 0;
+
+			for (size_t i = 0; i < n; i++) {
+				dlimb_t diff = static_cast<dlimb_t>(a[i]) - b[i] - borrow;
+				r[i] = static_cast<limb_t>(diff);
+				borrow = static_cast<limb_t>(diff >> (2 * limb_bits - 1));
+			}
+
+			return borrow;
+		}
+
+		limb_t mul_1(limb_t *r, limb_t const *a, size_t n, limb_t b) {
+			limb_t carry = 0;
+
+			for (size_t i = 0; i < n; i++) {
+				dlimb_t cur = static_cast<dlimb_t>(a[i]) * b + carry;
+				r[i] = static_cast<limb_t>(cur);
+				carry = static_cast<limb_t>(cur >> limb_bits);
+			}
+
+			return carry;
+		}
+
+		limb_t addmul_1(limb_t *r, limb_t const *a, size_t n, limb_t b) {
+			limb_t carry = 0;
+
+			for (size_t i = 0; i < n; i++) {
+				dlimb_t cur = static_cast<dlimb_t>(a[i]) * b + r[i] + carry;
+				r[i] = static_cast<limb_t>(cur);
+				carry = static_cast<limb_t>(cur >> limb_bits);
+			}
+
+			return carry;
+		}
+
+		limb_t submul_1(limb_t *r, limb_t const *a, size_t n, limb_t b) {
+			limb_t borrow = 0;
+
+			for (size_t i = 0; i < n; i++) {
+				dlimb_t cur = static_cast<dlimb_t>(a[i]) * b + borrow;
+				limb_t low = static_cast<limb_t>(cur);
+				borrow = static_cast<limb_t>(cur >> limb_bits) + (r[i] < low);
+				r[i] -= low;
+			}
+
+			return borrow;
+		}
+	}
+
+#if defined(__x86_64__)
+	namespace x86_64 {
+		limb_t add_n(limb_t *r, limb_t const *a, limb_t const *b, size_t n) {
+			size_t head = n % 4, blocks = n / 4;
+			limb_t carry = generic::add_n(r, a, b, head);
+
+			if (blocks == 0) {
+				return carry;
+			}
+
+			r += head;
+			a += head;
+			b += head;
+			limb_t t0, t1, t2, t3;
+
+			asm("negq %[carry]\n\t"
+			    "1:\n\t"
+			    "movq (%[a]), %[t0]\n\t"
+			    "movq 8(%[a]), %[t1]\n\t"
+			    "movq 16(%[a]), %[t2]\n\t"
+			    "movq 24(%[a]), %[t3]\n\t"
+			    "adcq (%[b]), %[t0]\n\t"
+			    "adcq 8(%[b]), %[t1]\n\t"
+			    "adcq 16(%[b]), %[t2]\n\t"
+			    "adcq 24(%[b]), %[t3]\n\t"
+			    "movq %[t0], (%[r])\n\t"
+			    "movq %[t1], 8(%[r])\n\t"
+			    "movq %[t2], 16(%[r])\n\t"
+			    "movq %[t3], 24(%[r])\n\t"
+			    "leaq 32(%[a]), %[a]\n\t"
+			    "leaq 32(%[b]), %[b]\n\t"
+			    "leaq 32(%[r]), %[r]\n\t"
+			    "leaq -1(%[n]), %[n]\n\t"
+			    "jrcxz 2f\n\t"
+			    "jmp 1b\n"
+			    "2:\n\t"
+			    "movl $0, %k[carry]\n\t"
+			    "adcl $0, %k[carry]"
+			    : [r] "+r"(r), [a] "+r"(a), [b] "+r"(b), [n] "+c"(blocks), [carry] "+r"(carry),
+			      [t0] "=&r"(t0), [t1] "=&r"(t1), [t2] "=&r"(t2), [t3] "=&r"(t3)
+			    :
+			    : "cc", "memory");
+
+			return carry;
+		}
+
+		limb_t sub_n(limb_t *r, limb_t const *a, limb_t const *b, size_t n) {
+			size_t head = n % 4, blocks = n / 4;
+			limb_t borrow = generic::sub_n(r, a, b, head);
+
+			if (blocks == 0) {
+				return borrow;
+			}
+
+			r += head;
+			a += head;
+			b += head;
+			limb_t t0, t1, t2, t3;
+
+			asm("negq %[borrow]\n\t"
+			    "1:\n\t"
+			    "movq (%[a]), %[t0]\n\t"
+			    "movq 8(%[a]), %[t1]\n\t"
+			    "movq 16(%[a]), %[t2]\n\t"
+			    "movq 24(%[a]), %[t3]\n\t"
+			    "sbbq (%[b]), %[t0]\n\t"
+			    "sbbq 8(%[b]), %[t1]\n\t"
+			    "sbbq 16(%[b]), %[t2]\n\t"
+			    "sbbq 24(%[b]), %[t3]\n\t"
+			    "movq %[t0], (%[r])\n\t"
+			    "movq %[t1], 8(%[r])\n\t"
+			    "movq %[t2], 16(%[r])\n\t"
+			    "movq %[t3], 24(%[r])\n\t"
+			    "leaq 32(%[a]), %[a]\n\t"
+			    "leaq 32(%[b]), %[b]\n\t"
+			    "leaq 32(%[r]), %[r]\n\t"
+			    "leaq -1(%[n]), %[n]\n\t"
+			    "jrcxz 2f\n\t"
+			    "jmp 1b\n"
+			    "2:\n\t"
+			    "movl $0, %k[borrow]\n\t"
+			    "adcl $0, %k[borrow]"
+			    : [r] "+r"(r), [a] "+r"(a), [b] "+r"(b), [n] "+c"(blocks), [borrow] "+r"(borrow),
+			      [t0] "=&r"(t0), [t1] "=&r"(t1), [t2] "=&r"(t2), [t3] "=&r"(t3)
+			    :
+			    : "cc", "memory");
+
+			return borrow;
+		}
+
+	}
+
+	namespace bmi2 {
+		// a single chain: low halves plus the previous high half through adc
+		limb_t mul_1(limb_t *r, limb_t const *a, size_t n, limb_t b) {
+			size_t head = n % 4, blocks = n / 4;
+			limb_t carry = generic::mul_1(r, a, head, b);
+
+			if (blocks == 0) {
+				return carry;
+			}
+
+			r += head;
+			a += head;
+			limb_t low, high;
+
+			asm("xorl %k[low], %k[low]\n\t"
+			    "1:\n\t"
+			    "mulxq (%[a]), %[low], %[high]\n\t"
+			    "adcq %[carry], %[low]\n\t"
+			    "movq %[low], (%[r])\n\t"
+			    "mulxq 8(%[a]), %[low], %[carry]\n\t"
+			    "adcq %[high], %[low]\n\t"
+			    "movq %[low], 8(%[r])\n\t"
+			    "mulxq 16(%[a]), %[low], %[high]\n\t"
+			    "adcq %[carry], %[low]\n\t"
+			    "movq %[low], 16(%[r])\n\t"
+			    "mulxq 24(%[a]), %[low], %[carry]\n\t"
+			    "adcq %[high], %[low]\n\t"
+			    "movq %[low], 24(%[r])\n\t"
+			    "leaq 32(%[a]), %[a]\n\t"
+			    "leaq 32(%[r]), %[r]\n\t"
+			    "leaq -1(%[n]), %[n]\n\t"
+			    "jrcxz 2f\n\t"
+			    "jmp 1b\n"
+			    "2:\n\t"
+			    "adcq $0, %[carry]"
+			    : [r] "+r"(r), [a] "+r"(a), [n] "+c"(blocks), [carry] "+r"(carry),
+			      [low] "=&r"(low), [high] "=&r"(high)
+			    : "d"(b)
+			    : "cc", "memory");
+
+			return carry;
+		}
+
+	}
+
+	namespace adx {
+		// adox sums the products into a * b, adcx adds that sum to r
+		limb_t addmul_1(limb_t *r, limb_t const *a, size_t n, limb_t b) {
+			size_t head = n % 4, blocks = n / 4;
+			limb_t carry = generic::addmul_1(r, a, head, b);
+
+			if (blocks == 0) {
+				return carry;
+			}
+
+			r += head;
+			a += head;
+			limb_t low, high;
+
+			asm("xorl %k[low], %k[low]\n\t"
+			    "1:\n\t"
+			    "mulxq (%[a]), %[low], %[high]\n\t"
+			    "adoxq %[carry], %[low]\n\t"
+			    "adcxq (%[r]), %[low]\n\t"
+			    "movq %[low], (%[r])\n\t"
+			    "mulxq 8(%[a]), %[low], %[carry]\n\t"
+			    "adoxq %[high], %[low]\n\t"
+			    "adcxq 8(%[r]), %[low]\n\t"
+			    "movq %[low], 8(%[r])\n\t"
+			    "mulxq 16(%[a]), %[low], %[high]\n\t"
+			    "adoxq %[carry], %[low]\n\t"
+			    "adcxq 16(%[r]), %[low]\n\t"
+			    "movq %[low], 16(%[r])\n\t"
+			    "mulxq 24(%[a]), %[low], %[carry]\n\t"
+			    "adoxq %[high], %[low]\n\t"
+			    "adcxq 24(%[r]), %[low]\n\t"
+			    "movq %[low], 24(%[r])\n\t"
+			    "leaq 32(%[a]), %[a]\n\t"
+			    "leaq 32(%[r]), %[r]\n\t"
+			    "leaq -1(%[n]), %[n]\n\t"
+			    "jrcxz 2f\n\t"
+			    "jmp 1b\n"
+			    "2:\n\t"
+			    "movl $0, %k[low]\n\t"
+			    "adoxq %[low], %[carry]\n\t"
+			    "adcxq %[low], %[carry]"
+			    : [r] "+r"(r), [a] "+r"(a), [n] "+c"(blocks), [carry] "+r"(carry),
+			      [low] "=&r"(low), [high] "=&r"(high)
+			    : "d"(b)
+			    : "cc", "memory");
+
+			return carry;
+		}
+
+		// r - p is computed as r + ~p + 1, so the CF chain starts set and a
+		// borrow out of the array is a clear CF at the end
+		limb_t submul_1(limb_t *r, limb_t const *a, size_t n, limb_t b) {
+			size_t head = n % 4, blocks = n / 4;
+			limb_t borrow = generic::submul_1(r, a, head, b);
+
+			if (blocks == 0) {
+				return borrow;
+			}
+
+			r += head;
+			a += head;
+			limb_t low, high;
+
+			asm("xorl %k[low], %k[low]\n\t"
+			    "stc\n"
+			    "1:\n\t"
+			    "mulxq (%[a]), %[low], %[high]\n\t"
+			    "adoxq %[borrow], %[low]\n\t"
+			    "notq %[low]\n\t"
+			    "adcxq (%[r]), %[low]\n\t"
+			    "movq %[low], (%[r])\n\t"
+			    "mulxq 8(%[a]), %[low], %[borrow]\n\t"
+			    "adoxq %[high], %[low]\n\t"
+			    "notq %[low]\n\t"
+			    "adcxq 8(%[r]), %[low]\n\t"
+			    "movq %[low], 8(%[r])\n\t"
+			    "mulxq 16(%[a]), %[low], %[high]\n\t"
+			    "adoxq %[borrow], %[low]\n\t"
+			    "notq %[low]\n\t"
+			    "adcxq 16(%[r]), %[low]\n\t"
+			    "movq %[low], 16(%[r])\n\t"
+			    "mulxq 24(%[a]), %[low], %[borrow]\n\t"
+			    "adoxq %[high], %[low]\n\t"
+			    "notq %[low]\n\t"
+			    "adcxq 24(%[r]), %[low]\n\t"
+			    "movq %[low], 24(%[r])\n\t"
+			    "leaq 32(%[a]), %[a]\n\t"
+			    "leaq 32(%[r]), %[r]\n\t"
+			    "leaq -1(%[n]), %[n]\n\t"
+			    "jrcxz 2f\n\t"
+			    "jmp 1b\n"
+			    "2:\n\t"
+			    "movl $0, %k[low]\n\t"
+			    "adoxq %[low], %[borrow]\n\t"
+			    "cmc\n\t"
+			    "adcq %[low], %[borrow]"
+			    : [r] "+r"(r), [a] "+r"(a), [n] "+c"(blocks), [borrow] "+r"(borrow),
+			      [low] "=&r"(low), [high] "=&r"(high)
+			    : "d"(b)
+			    : "cc", "memory");
+
+			return borrow;
+		}
+	}
+#endif
+}
@@ -0,0 +1,109 @@
+#include "big_integer_dispatch.h"
+
+namespace kernels {
+	dispatch_table dispatch = {
+			generic::compare,
+			generic::bitwise_n,
+			generic::add_n,
+			generic::sub_n,
+			generic::mul_1,
+			generic::addmul_1,
+			generic::submul_1
+	};
+
+	namespace {
+		cpu_features detect() {
+			cpu_features result = {};
+#if defined(__x86_64__)
+			__builtin_cpu_init();
+			result.baseline = true;
+			result.bmi2 = __builtin_cpu_supports("bmi2");
+			result.adx = __builtin_cpu_supports("adx");
+			result.avx2 = __builtin_cpu_supports("avx2");
+			result.avx512 = __builtin_cpu_supports("avx512f");
+#endif
+			return result;
+		}
+
+		struct startup_selection {
+			startup_selection() {
+				select_kernels(detected_cpu_features());
+			}
+		} const startup;
+	}
+
+	cpu_features const &detected_cpu_features() {
+		static cpu_features const result = detect();
+		return result;
+	}
+
+	void select_kernels(cpu_features const &features) {
+		dispatch_table selected = {
+				generic::compare,
+				generic::bitwise_n,
+				generic::add_n,
+				generic::sub_n,
+				generic::mul_1,
+				generic::addmul_1,
+				generic::submul_1
+		};
+
+#if defined(__x86_64__)
+		// adc and sbb are part of the base instruction set
+		if (features.baseline) {
+			selected.add_n = x86_64::add_n;
+			selected.sub_n = x86_64::sub_n;
+		}
+
+		if (features.bmi2) {
+			selected.mul_1 = bmi2::mul_1;
+		}
+
+		if (features.bmi2 && features.adx) {
+			selected.addmul_1 = adx::addmul_1;
+			selected.submul_1 = adx::submul_1;
+		}
+
+		if (features.avx512) {
+			selected.compare = avx512::compare;
+			selected.bitwise_n = avx512::bitwise_n;
+		} else if (features.avx2) {
+			selected.compare = avx2::compare;
+			selected.bitwise_n = avx2::bitwise_n;
+		}
+#else
+		static_cast<void>(features);
+#endif
+
+		dispatch = selected;
+	}
+
+	int compare(limb_t const *a, limb_t const *b, size_t n) {
+		return dispatch.compare(a, b, n);
+	}
+
+	void bitwise_n(limb_t *r, limb_t const *a, limb_t const *b, size_t n, bit_op op,
+	               limb_t mask_a, limb_t mask_b, limb_t mask_r) {
+		dispatch.bitwise_n(r, a, b, n, op, mask_a, mask_b, mask_r);
+	}
+
+	limb_t add_n(limb_t *r, limb_t const *a, limb_t const *b, size_t n) {
+		return dispatch.add_n(r, a, b, n);
+	}
+
+	limb_t sub_n(limb_t *r, limb_t const *a, limb_t const *b, size_t n) {
+		return dispatch.sub_n(r, a, b, n);
+	}
+
+	limb_t mul_1(limb_t *r, limb_t const *a, size_t n, limb_t b) {
+		return dispatch.mul_1(r, a, n, b);
+	}
+
+	limb_t addmul_1(limb_t *r, limb_t const *a, size_t n, limb_t b) {
+		return dispatch.addmul_1(r, a, n, b);
+	}
+
+	limb_t submul_1(limb_t *r, limb_t const *a, size_t n, limb_t b) {
+		return dispatch.submul_1(r, a, n, b);
+	}
+}
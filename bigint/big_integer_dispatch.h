@@ -0,0 +1,63 @@
+#ifndef BIG_INTEGER_DISPATCH_H
+#define BIG_INTEGER_DISPATCH_H
+
+#include "big_integer_kernels.h"
+
+// The primitives that have more than one implementation call through this
+// table. It starts out with the portable versions, so it is usable during
+// static initialization, and select_kernels fills in the rest before main.
+namespace kernels {
+	struct dispatch_table {
+		int (*compare)(limb_t const *a, limb_t const *b, size_t n);
+		void (*bitwise_n)(limb_t *r, limb_t const *a, limb_t const *b, size_t n, bit_op op,
+		                  limb_t mask_a, limb_t mask_b, limb_t mask_r);
+		limb_t (*add_n)(limb_t *r, limb_t const *a, limb_t const *b, size_t n);
+		limb_t (*sub_n)(limb_t *r, limb_t const *a, limb_t const *b, size_t n);
+		limb_t (*mul_1)(limb_t *r, limb_t const *a, size_t n, limb_t b);
+		limb_t (*addmul_1)(limb_t *r, limb_t const *a, size_t n, limb_t b);
+		limb_t (*submul_1)(limb_t *r, limb_t const *a, size_t n, limb_t b);
+	};
+
+	extern dispatch_table dispatch;
+
+	namespace generic {
+		int compare(limb_t const *a, limb_t const *b, size_t n);
+		void bitwise_n(limb_t *r, limb_t const *a, limb_t const *b, size_t n, bit_op op,
+		               limb_t mask_a, limb_t mask_b, limb_t mask_r);
+		limb_t add_n(limb_t *r, limb_t const *a, limb_t const *b, size_t n);
+		limb_t sub_n(limb_t *r, limb_t const *a, limb_t const *b, size_t n);
+		limb_t mul_1(limb_t *r, limb_t const *a, size_t n, limb_t b);
+		limb_t addmul_1(limb_t *r, limb_t const *a, size_t n, limb_t b);
+		limb_t submul_1(limb_t *r, limb_t const *a, size_t n, limb_t b);
+	}
+
+#if defined(__x86_64__)
+	namespace x86_64 {
+		limb_t add_n(limb_t *r, limb_t const *a, limb_t const *b, size_t n);
+		limb_t sub_n(limb_t *r, limb_t const *a, limb_t const *b, size_t n);
+	}
+
+	namespace bmi2 {
+		limb_t mul_1(limb_t *r, limb_t const *a, size_t n, limb_t b);
+	}
+
+	namespace adx {
+		limb_t addmul_1(limb_t *r, limb_t const *a, size_t n, limb_t b);
+		limb_t submul_1(limb_t *r, limb_t const *a, size_t n, limb_t b);
+	}
+
+	namespace avx2 {
+		int compare(limb_t const *a, limb_t const *b, size_t n);
+		void bitwise_n(limb_t *r, limb_t const *a, limb_t const *b, size_t n, bit_op op,
+		               limb_t mask_a, limb_t mask_b, limb_t mask_r);
+	}
+
+	namespace avx512 {
+		int compare(limb_t const *a, limb_t const *b, size_t n);
+		void bitwise_n(limb_t *r, limb_t const *a, limb_t const *b, size_t n, bit_op op,
+		               limb_t mask_a, limb_t mask_b, limb_t mask_r);
+	}
+#endif
+}
+
+#endif // BIG_INTEGER_DISPATCH_H
@@ -0,0 +1,454 @@
+#include "big_integer_kernels.h"
+#include "big_integer_arena.h"
+#include "big_integer_parallel.h"
+#include <algorithm>
+
+namespace kernels {
+	size_t karatsuba_threshold = 40;
+	size_t sqr_karatsuba_threshold = 96;
+	size_t toom3_threshold = 192;
+	size_t bz_threshold = 48;
+
+	limb_t add(limb_t *r, limb_t const *a, size_t n, limb_t const *b, size_t m) {
+		limb_t carry = add_n(r, a, b, m);
+
+		for (size_t i = m; i < n; i++) {
+			r[i] = a[i] + carry;
+			carry = r[i] < carry;
+		}
+
+		return carry;
+	}
+
+	limb_t sub(limb_t *r, limb_t const *a, size_t n, limb_t const *b, size_t m) {
+		limb_t borrow = sub_n(r, a, b, m);
+
+		for (size_t i = m; i < n; i++) {
+			limb_t cur = a[i];
+			r[i] = cur - borrow;
+			borrow = cur < borrow;
+		}
+
+		return borrow;
+	}
+
+	limb_t lshift(limb_t *r, limb_t const *a, size_t n, uint32_t cnt) {
+		limb_t out = a[n - 1] >> (limb_bits - cnt);
+
+		for (size_t i = n - 1; i > 0; i--) {
+			r[i] = (a[i] << cnt) | (a[i - 1] >> (limb_bits - cnt));
+		}
+
+		r[0] = a[0] << cnt;
+		return out;
+	}
+
+	limb_t rshift(limb_t *r, limb_t const *a, size_t n, uint32_t cnt) {
+		limb_t out = a[0] << (limb_bits - cnt);
+
+		for (size_t i = 0; i + 1 < n; i++) {
+			r[i] = (a[i] >> cnt) | (a[i + 1] << (limb_bits - cnt));
+		}
+
+		r[n - 1] = a[n - 1] >> cnt;
+		return out;
+	}
+
+	limb_t div_1(limb_t *q, limb_t const *a, size_t n, limb_t b) {
+		dlimb_t remainder = 0;
+
+		for (size_t i = n; i > 0; i--) {
+			remainder = (remainder << limb_bits) | a[i - 1];
+			q[i - 1] = static_cast<limb_t>(remainder / b);
+			remainder %= b;
+		}
+
+		return static_cast<limb_t>(remainder);
+	}
+
+	// Knuth, TAOCP vol. 2, 4.3.1, Algorithm D
+	void div_qr_basecase(limb_t *q, limb_t *u, size_t n, limb_t const *v, size_t m) {
+		limb_t const v1 = v[m - 1];
+		limb_t const v2 = v[m - 2];
+
+		for (size_t j = n - m; j > 0; j--) {
+			limb_t *window = u + j - 1;
+			limb_t top = window[m];
+			limb_t qhat;
+			dlimb_t rhat;
+
+			if (top >= v1) {
+				qhat = ~limb_t(0);
+				rhat = static_cast<dlimb_t>(window[m - 1]) + v1;
+			} else {
+				dlimb_t numerator = (static_cast<dlimb_t>(top) << limb_bits) | window[m - 1];
+				qhat = static_cast<limb_t>(numerator / v1);
+				rhat = numerator % v1;
+			}
+
+			// after this qhat exceeds the real digit by at most one
+			while (!(rhat >> limb_bits) && static_cast<dlimb_t>(qhat) * v2 > ((rhat << limb_bits) | window[m - 2])) {
+				qhat--;
+				rhat += v1;
+			}
+
+			limb_t borrow = submul_1(window, v, m, qhat);
+			window[m] = top - borrow;
+
+			if (top < borrow) {
+				qhat--;
+				window[m] += add_n(window, window, v, m);
+			}
+
+			q[j - 1] = qhat;
+		}
+	}
+
+	void mul_basecase(limb_t *r, limb_t const *a, size_t n, limb_t const *b, size_t m) {
+		r[n] = mul_1(r, a, n, b[0]);
+
+		for (size_t j = 1; j < m; j++) {
+			r[n + j] = addmul_1(r + j, a, n, b[j]);
+		}
+	}
+
+	// every product a[i] * a[j] with i < j once, doubled, plus the squares a[i]^2
+	void sqr_basecase(limb_t *r, limb_t const *a, size_t n) {
+		r[0] = 0;
+		r[n] = mul_1(r + 1, a + 1, n - 1, a[0]);
+
+		for (size_t i = 1; i < n; i++) {
+			r[i + n] = addmul_1(r + 2 * i + 1, a + i + 1, n - i - 1, a[i]);
+		}
+
+		lshift(r, r, 2 * n, 1);
+		limb_t carry = 0;
+
+		for (size_t i = 0; i < n; i++) {
+			dlimb_t square = static_cast<dlimb_t>(a[i]) * a[i];
+			dlimb_t low = static_cast<dlimb_t>(r[2 * i]) + static_cast<limb_t>(square) + carry;
+			dlimb_t high = static_cast<dlimb_t>(r[2 * i + 1]) + static_cast<limb_t>(square >> limb_bits) + static_cast<limb_t>(low >> limb_bits);
+			r[2 * i] = static_cast<limb_t>(low);
+			r[2 * i + 1] = static_cast<limb_t>(high);
+			carry = static_cast<limb_t>(high >> limb_bits);
+		}
+	}
+
+	namespace {
+		using buffer = scratch_buffer<limb_t>;
+
+		// r[offset..rn) += a[0..an), the sum is known to fit into rn limbs
+		void add_at(limb_t *r, size_t rn, limb_t const *a, size_t an, size_t offset) {
+			while (an > 0 && a[an - 1] == 0) {
+				an--;
+			}
+
+			if (an > 0) {
+				add(r + offset, r + offset, rn - offset, a, an);
+			}
+		}
+
+		// r[0..n) = |a[0..n) - b[0..m)|, requires n >= m, returns whether a < b
+		bool abs_diff(limb_t *r, limb_t const *a, size_t n, limb_t const *b, size_t m) {
+			bool less = std::all_of(a + m, a + n, [](limb_t x) { return x == 0; }) && compare(a, b, m) < 0;
+
+			if (less) {
+				sub_n(r, b, a, m);
+				std::fill(r + m, r + n, 0);
+			} else {
+				sub(r, a, n, b, m);
+			}
+
+			return less;
+		}
+
+		void mul_unbalanced(limb_t *r, limb_t const *a, size_t n, limb_t const *b, size_t m) {
+			std::fill(r, r + n + m, 0);
+
+			if (m >= parallel_threshold) {
+				// products of even chunks do not overlap and go straight to r,
+				// the odd ones are laid out the same way m limbs lower in odd
+				buffer odd(n);
+
+				parallel_for((n + m - 1) / m, [&](size_t chunk) {
+					size_t i = chunk * m;
+					mul(chunk % 2 == 0 ? r + i : odd.data() + i - m, b, m, a + i, std::min(m, n - i));
+				});
+
+				add_at(r, n + m, odd.data(), n, m);
+				return;
+			}
+
+			buffer chunk(2 * m);
+
+			for (size_t i = 0; i < n; i += m) {
+				size_t len = std::min(m, n - i);
+				mul(chunk.data(), b, m, a + i, len);
+				add_at(r, n + m, chunk.data(), len + m, i);
+			}
+		}
+
+		// a0*b1 + a1*b0 = a0*b0 + a1*b1 - (a0 - a1)(b0 - b1), requires (n + 1) / 2 < m <= n
+		void mul_karatsuba(limb_t *r, limb_t const *a, size_t n, limb_t const *b, size_t m) {
+			size_t h = (n + 1) / 2;
+			bool square = a == b && n == m;
+			buffer da(h), db(square ? 0 : h), z1(2 * h), middle(2 * h + 1);
+
+			// (a0 - a1)^2 is never negative
+			bool negative = abs_diff(da.data(), a, h, a + h, n - h);
+			limb_t const *d = da.data();
+
+			if (square) {
+				negative = false;
+			} else {
+				negative = negative != abs_diff(db.data(), b, h, b + h, m - h);
+				d = db.data();
+			}
+
+			parallel_for(3, m, [&](size_t i) {
+				if (i == 0) {
+					mul(r, a, h, b, h);
+				} else if (i == 1) {
+					mul(r + 2 * h, a + h, n - h, b + h, m - h);
+				} else {
+					mul(z1.data(), da.data(), h, d, h);
+				}
+			});
+
+			std::copy(r, r + 2 * h, middle.begin());
+			add(middle.data(), middle.data(), 2 * h + 1, r + 2 * h, n + m - 2 * h);
+
+			if (negative) {
+				add(middle.data(), middle.data(), 2 * h + 1, z1.data(), 2 * h);
+			} else {
+				sub(middle.data(), middle.data(), 2 * h + 1, z1.data(), 2 * h);
+			}
+
+			add_at(r, n + m, middle.data(), 2 * h + 1, h);
+		}
+
+		// p[0..k] = a2 * x^2 + a1 * x + a0, where a = a0 + a1 * B^k + a2 * B^2k
+		void toom3_evaluate(limb_t *p, limb_t const *a, size_t n, size_t k, limb_t x) {
+			std::fill(p, p + k + 1, 0);
+			std::copy(a + 2 * k, a + n, p);
+
+			for (size_t part = 2; part > 0; part--) {
+				mul_1(p, p, k + 1, x);
+				add(p, p, k + 1, a + (part - 1) * k, k);
+			}
+		}
+
+		// Toom-3 with evaluation points 0, 1, 2, 3 and infinity. All of them are
+		// non-negative, so every intermediate value of the interpolation is too.
+		// Requires m > 2 * ceil(n / 3).
+		void mul_toom3(limb_t *r, limb_t const *a, size_t n, limb_t const *b, size_t m) {
+			size_t k = (n + 2) / 3;
+			size_t len = 2 * k + 2;
+			size_t c4_len = n + m - 4 * k;
+
+			bool square = a == b && n == m;
+			buffer pa(3 * (k + 1)), pb(square ? 0 : 3 * (k + 1)), tmp(len);
+			buffer values[3] = {buffer(len), buffer(len), buffer(len)};
+
+			for (limb_t x = 1; x <= 3; x++) {
+				toom3_evaluate(pa.data() + (x - 1) * (k + 1), a, n, k, x);
+
+				if (!square) {
+					toom3_evaluate(pb.data() + (x - 1) * (k + 1), b, m, k, x);
+				}
+			}
+
+			limb_t *c0 = r;
+			limb_t *c4 = r + 4 * k;
+
+			parallel_for(5, m, [&](size_t i) {
+				if (i < 3) {
+					limb_t const *p = pa.data() + i * (k + 1);
+					mul(values[i].data(), p, k + 1, square ? p : pb.data() + i * (k + 1), k + 1);
+				} else if (i == 3) {
+					mul(c0, a, k, b, k);
+				} else {
+					mul(c4, a + 2 * k, n - 2 * k, b + 2 * k, m - 2 * k);
+				}
+			});
+
+			std::fill(r + 2 * k, r + 4 * k, 0);
+
+			// values[x - 1] = (r(x) - c0 - x^4 * c4) / x = c1 + x * c2 + x^2 * c3
+			limb_t const powers[3] = {1, 16, 81};
+
+			for (limb_t x = 1; x <= 3; x++) {
+				limb_t *v = values[x - 1].data();
+				sub(v, v, len, c0, 2 * k);
+
+				std::fill(tmp.begin(), tmp.end(), 0);
+				tmp[c4_len] = mul_1(tmp.data(), c4, c4_len, powers[x - 1]);
+				sub(v, v, len, tmp.data(), c4_len + 1);
+
+				div_1(v, v, len, x);
+			}
+
+			limb_t *s1 = values[0].data();
+			limb_t *s2 = values[1].data();
+			limb_t *s3 = values[2].data();
+
+			sub_n(s3, s3, s2, len);        // c2 + 5 * c3
+			sub_n(s2, s2, s1, len);        // c2 + 3 * c3
+			sub_n(s3, s3, s2, len);
+			div_1(s3, s3, len, 2);         // c3
+
+			mul_1(tmp.data(), s3, len, 3);
+			sub_n(s2, s2, tmp.data(), len); // c2
+			sub_n(s1, s1, s2, len);
+			sub_n(s1, s1, s3, len);        // c1
+
+			add_at(r, n + m, s1, len, k);
+			add_at(r, n + m, s2, len, 2 * k);
+			add_at(r, n + m, s3, len, 3 * k);
+		}
+
+		limb_t div_block(limb_t *q, limb_t *u, size_t k, limb_t const *v, size_t m);
+
+		// q[0..n) = u[0..2n) / v[0..n), returns the quotient limb above q
+		limb_t div_2n_1n(limb_t *q, limb_t *u, limb_t const *v, size_t n) {
+			size_t low = n / 2, high = n - low;
+			limb_t q_top = div_block(q + low, u + low, high, v, n);
+			div_block(q, u, low, v, n);
+			return q_top;
+		}
+
+		// Burnikel and Ziegler, Fast Recursive Division. The k quotient limbs of
+		// u[0..m+k) / v[0..m) are estimated by dividing the top 2k limbs of u by
+		// the top k limbs of v, which is at most 2 too large once the product
+		// of the estimate and the rest of v is subtracted. Requires k <= m.
+		limb_t div_block(limb_t *q, limb_t *u, size_t k, limb_t const *v, size_t m) {
+			if (k < bz_threshold) {
+				limb_t q_top = compare(u + k, v, m) >= 0;
+
+				if (q_top) {
+					sub_n(u + k, u + k, v, m);
+				}
+
+				div_qr_basecase(q, u, m + k, v, m);
+				return q_top;
+			}
+
+			limb_t q_top = div_2n_1n(q, u + m - k, v + m - k, k);
+
+			if (k < m) {
+				buffer product(m);
+
+				if (m - k >= k) {
+					mul(product.data(), v, m - k, q, k);
+				} else {
+					mul(product.data(), q, k, v, m - k);
+				}
+
+				limb_t borrow = sub_n(u, u, product.data(), m);
+
+				if (q_top) {
+					borrow += sub_n(u + k, u + k, v, m - k);
+				}
+
+				limb_t const one = 1;
+
+				while (borrow) {
+					q_top -= sub(q, q, k, &one, 1);
+					borrow -= add_n(u, u, v, m);
+				}
+			}
+
+			return q_top;
+		}
+
+		// The transform runs on 2 * limbs coefficients rounded up to a power of
+		// two. Padded to more than 1.5 times that, splitting once more is faster.
+		bool ntt_pads_little(size_t limbs) {
+			size_t size = 1;
+
+			while (size < 2 * limbs) {
+				size <<= 1u;
+			}
+
+			return size <= 3 * limbs;
+		}
+	}
+
+	void mul(limb_t *r, limb_t const *a, size_t n, limb_t const *b, size_t m) {
+		if (a == b && n == m && n < sqr_karatsuba_threshold) {
+			sqr_basecase(r, a, n);
+		} else if (m < karatsuba_threshold) {
+			mul_basecase(r, a, n, b, m);
+		} else if (m >= ntt_threshold && n + m <= ntt_max_size && ntt_pads_little(n + m)) {
+			mul_ntt(r, a, n, b, m);
+		} else if (m <= (n + 1) / 2) {
+			mul_unbalanced(r, a, n, b, m);
+		} else if (m >= toom3_threshold && m > 2 * ((n + 2) / 3)) {
+			mul_toom3(r, a, n, b, m);
+		} else {
+			mul_karatsuba(r, a, n, b, m);
+		}
+	}
+
+	void sqr(limb_t *r, limb_t const *a, size_t n) {
+		mul(r, a, n, a, n);
+	}
+
+	// Montgomery reduction, every step adds the multiple of m which clears t[i]
+	void redc(limb_t *r, limb_t *t, limb_t const *m, size_t n, limb_t m_inv) {
+		limb_t top = 0;
+
+		for (size_t i = 0; i < n; i++) {
+			limb_t carry = addmul_1(t + i, m, n, t[i] * m_inv);
+			dlimb_t sum = static_cast<dlimb_t>(t[i + n]) + carry + top;
+			t[i + n] = static_cast<limb_t>(sum);
+			top = static_cast<limb_t>(sum >> limb_bits);
+		}
+
+		if (top || compare(t + n, m, n) >= 0) {
+			sub_n(r, t + n, m, n);
+		} else {
+			std::copy(t + n, t + 2 * n, r);
+		}
+	}
+
+	// a0 * b0 + (a1 * b0 + a0 * b1) * B^h, the last two only modulo B^(n-h)
+	void mul_low(limb_t *r, limb_t const *a, limb_t const *b, size_t n) {
+		if (n < karatsuba_threshold) {
+			mul_1(r, a, n, b[0]);
+
+			for (size_t j = 1; j < n; j++) {
+				addmul_1(r + j, a, n - j, b[j]);
+			}
+
+			return;
+		}
+
+		size_t h = n - n / 2;
+		buffer full(2 * h), cross(n - h);
+
+		mul(full.data(), a, h, b, h);
+		std::copy(full.begin(), full.begin() + n, r);
+
+		mul_low(cross.data(), a + h, b, n - h);
+		add_n(r + h, r + h, cross.data(), n - h);
+		mul_low(cross.data(), a, b + h, n - h);
+		add_n(r + h, r + h, cross.data(), n - h);
+	}
+
+	void div_qr(limb_t *q, limb_t *u, size_t n, limb_t const *v, size_t m) {
+		if (m < bz_threshold || n - m < bz_threshold) {
+			div_qr_basecase(q, u, n, v, m);
+			return;
+		}
+
+		// quotient blocks of m limbs from the top, each one divides the
+		// remainder left by the previous one extended with the next limbs of u
+		size_t qn = n - m;
+		size_t k = qn % m == 0 ? m : qn % m;
+
+		for (; qn > 0; qn -= k, k = m) {
+			div_block(q + qn - k, u + qn - k, k, v, m);
+		}
+	}
+}
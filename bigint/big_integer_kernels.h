@@ -0,0 +1,109 @@
+#ifndef BIG_INTEGER_KERNELS_H
+#define BIG_INTEGER_KERNELS_H
+
+#include <cstddef>
+#include <cstdint>
+
+// Low-level routines over little-endian limb arrays. Sizes are passed
+// explicitly and arrays are not required to be normalized.
+namespace kernels {
+	using limb_t = uint64_t;
+	using dlimb_t = unsigned int __attribute__((mode(TI)));
+
+	const size_t limb_bits = 64;
+
+	// Operand sizes (in limbs of the smaller operand) from which
+	// the corresponding multiplication algorithm is used.
+	extern size_t karatsuba_threshold;
+	extern size_t sqr_karatsuba_threshold;
+	extern size_t toom3_threshold;
+	extern size_t ntt_threshold;
+
+	// Divisor size (in limbs) from which division is done recursively.
+	extern size_t bz_threshold;
+
+	// Longest product the number theoretic transform can handle.
+	const size_t ntt_max_size = size_t(1) << 23u;
+
+	// Operand size (in limbs of the smaller operand) from which the
+	// independent subproducts of a multiplication, and the halves of a radix
+	// conversion, run on separate threads. Results do not depend on it or on
+	// the thread count.
+	extern size_t parallel_threshold;
+
+	// Threads the kernels may use, including the calling one. Defaults to
+	// the number of hardware threads, 1 keeps all work on the calling thread.
+	// Not safe while other threads use kernels.
+	size_t thread_count();
+	void set_thread_count(size_t count);
+
+	// Instruction set extensions the kernels can use. At startup every
+	// primitive is switched to the best implementation the processor allows.
+	struct cpu_features {
+		// the base instruction set the library has kernels for, x86-64
+		bool baseline;
+		bool bmi2;
+		bool adx;
+		bool avx2;
+		bool avx512;
+	};
+
+	cpu_features const &detected_cpu_features();
+
+	// Switches to the best implementations within features, which must be
+	// supported by the processor. Not safe while other threads use kernels.
+	void select_kernels(cpu_features const &features);
+
+	int compare(limb_t const *a, limb_t const *b, size_t n);
+
+	enum class bit_op { bit_and, bit_or, bit_xor };
+
+	// r[i] = mask_r ^ op(a[i] ^ mask_a, b[i] ^ mask_b) with every mask either
+	// 0 or all ones, r may be equal to a or b
+	void bitwise_n(limb_t *r, limb_t const *a, limb_t const *b, size_t n, bit_op op,
+	               limb_t mask_a, limb_t mask_b, limb_t mask_r);
+	void com(limb_t *r, limb_t const *a, size_t n);
+
+	limb_t add_n(limb_t *r, limb_t const *a, limb_t const *b, size_t n);
+	limb_t sub_n(limb_t *r, limb_t const *a, limb_t const *b, size_t n);
+
+	// r[0..n) = a[0..n) +/- b[0..m), requires n >= m
+	limb_t add(limb_t *r, limb_t const *a, size_t n, limb_t const *b, size_t m);
+	limb_t sub(limb_t *r, limb_t const *a, size_t n, limb_t const *b, size_t m);
+
+	// shift by 0 < cnt < limb_bits, return the bits shifted out
+	limb_t lshift(limb_t *r, limb_t const *a, size_t n, uint32_t cnt);
+	limb_t rshift(limb_t *r, limb_t const *a, size_t n, uint32_t cnt);
+
+	limb_t mul_1(limb_t *r, limb_t const *a, size_t n, limb_t b);
+	limb_t addmul_1(limb_t *r, limb_t const *a, size_t n, limb_t b);
+	limb_t submul_1(limb_t *r, limb_t const *a, size_t n, limb_t b);
+	limb_t div_1(limb_t *q, limb_t const *a, size_t n, limb_t b);
+
+	void mul_basecase(limb_t *r, limb_t const *a, size_t n, limb_t const *b, size_t m);
+	void sqr_basecase(limb_t *r, limb_t const *a, size_t n);
+	void mul_ntt(limb_t *r, limb_t const *a, size_t n, limb_t const *b, size_t m);
+
+	// r[0..n+m) = a[0..n) * b[0..m), requires n >= m >= 1,
+	// r must not overlap with a or b. Squares if a == b and n == m.
+	void mul(limb_t *r, limb_t const *a, size_t n, limb_t const *b, size_t m);
+
+	// r[0..2n) = a[0..n)^2, r must not overlap with a
+	void sqr(limb_t *r, limb_t const *a, size_t n);
+
+	// r[0..n) = a[0..n) * b[0..n) mod 2^(n * limb_bits),
+	// r must not overlap with a or b
+	void mul_low(limb_t *r, limb_t const *a, limb_t const *b, size_t n);
+
+	// r[0..n) = t[0..2n) / 2^(n * limb_bits) mod m[0..n), t is overwritten.
+	// Requires t < m * 2^(n * limb_bits), m odd and m_inv * m[0] = -1 mod 2^limb_bits.
+	void redc(limb_t *r, limb_t *t, limb_t const *m, size_t n, limb_t m_inv);
+
+	void div_qr_basecase(limb_t *q, limb_t *u, size_t n, limb_t const *v, size_t m);
+
+	// q[0..n-m) = u[0..n) / v[0..m), the remainder is left in u[0..m).
+	// Requires m >= 2, the highest bit of v[m - 1] set and u[n-m..n) < v.
+	void div_qr(limb_t *q, limb_t *u, size_t n, limb_t const *v, size_t m);
+}
+
+#endif // BIG_INTEGER_KERNELS_H
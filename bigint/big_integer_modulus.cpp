@@ -0,0 +1,130 @@
+#include "big_integer_modulus.h"
+#include "big_integer_arena.h"
+#include <algorithm>
+#include <stdexcept>
+#include <utility>
+
+namespace {
+	// below this many bits the reciprocal is found by a plain division
+	const uint32_t newton_threshold = 1024;
+
+	// floor(2^(2k) / a), requires 2^(k - 1) <= a < 2^k
+	big_integer inverse(big_integer const &a, uint32_t k) {
+		if (k <= newton_threshold) {
+			return (big_integer(1) << 2 * k) / a;
+		}
+
+		// the inverse of the top half of a is precise in about half of the
+		// bits, one Newton step x = 2x - a * x^2 / 2^(2k) doubles that
+		uint32_t half = (k + 1) / 2;
+		big_integer x = inverse(a >> (k - half), half) << (k - half);
+		x = (x << 1) - ((a * x * x) >> 2 * k);
+
+		big_integer rest = (big_integer(1) << 2 * k) - a * x;
+
+		while (rest < 0) {
+			--x;
+			rest += a;
+		}
+
+		while (rest >= a) {
+			++x;
+			rest -= a;
+		}
+
+		return x;
+	}
+
+	using storage_t = big_integer::storage_t;
+
+	void trim(storage_t &a) {
+		while (a.size() > 1 && std::as_const(a).back() == 0) {
+			a.pop_back();
+		}
+	}
+
+	storage_t shift_right(storage_t const &a, uint32_t shift) {
+		size_t skip = shift / kernels::limb_bits;
+		uint32_t cnt = shift % kernels::limb_bits;
+
+		if (skip >= a.size()) {
+			return storage_t(1);
+		}
+
+		storage_t result(a.size() - skip);
+
+		if (cnt > 0) {
+			kernels::rshift(result.data(), a.data() + skip, result.size(), cnt);
+		} else {
+			std::copy(a.begin() + skip, a.end(), result.data());
+		}
+
+		trim(result);
+		return result;
+	}
+
+	storage_t multiply(storage_t const &a, storage_t const &b) {
+		storage_t result(a.size() + b.size());
+
+		if (a.size() >= b.size()) {
+			kernels::mul(result.data(), a.data(), a.size(), b.data(), b.size());
+		} else {
+			kernels::mul(result.data(), b.data(), b.size(), a.data(), a.size());
+		}
+
+		trim(result);
+		return result;
+	}
+}
+
+big_integer_modulus::big_integer_modulus(big_integer const &modulus) : mod(modulus) {
+	if (mod.is_zero()) {
+		throw std::range_error("division by zero");
+	}
+
+	mod.sign = true;
+	bits = bit_length(mod);
+	reciprocal = inverse(mod, bits);
+
+	padded_mod = mod.dig;
+	padded_mod.push_back(0);
+}
+
+big_integer const &big_integer_modulus::modulus() const {
+	return mod;
+}
+
+uint32_t big_integer_modulus::bit_length(big_integer const &a) {
+	return static_cast<uint32_t>(kernels::limb_bits * a.size() - __builtin_clzll(a.dig.back()));
+}
+
+big_integer big_integer_modulus::reduce(big_integer const &a) const {
+	if (a.size() < mod.size() || (a.size() == mod.size() && kernels::compare(a.dig.data(), mod.dig.data(), a.size()) < 0)) {
+		return a;
+	} else if (bit_length(a) > 2 * bits) {
+		return a % mod;
+	}
+
+	// the quotient estimate is at most 2 below the real one
+	storage_t estimate = shift_right(a.dig, bits - 1);
+	estimate = shift_right(multiply(estimate, reciprocal.dig), bits + 1);
+
+	// the remainder is below 3 * mod, so only that many low limbs of the
+	// product are needed
+	size_t n = mod.size() + 1;
+	kernels::scratch_buffer<big_integer::limb_t> x(n), q(n), product(n);
+	storage_t rest(n);
+	std::copy(a.dig.begin(), a.dig.begin() + std::min(n, a.size()), x.data());
+	std::copy(estimate.begin(), estimate.end(), q.data());
+
+	kernels::mul_low(product.data(), q.data(), padded_mod.data(), n);
+	kernels::sub_n(rest.data(), x.data(), product.data(), n);
+	trim(rest);
+
+	while (rest.size() > mod.size() || (rest.size() == mod.size() && kernels::compare(rest.data(), mod.dig.data(), rest.size()) >= 0)) {
+		kernels::sub(rest.data(), rest.data(), rest.size(), mod.dig.data(), mod.size());
+		trim(rest);
+	}
+
+	return big_integer(a.sign, std::move(rest));
+}
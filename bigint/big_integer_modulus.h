@@ -0,0 +1,26 @@
+#ifndef BIG_INTEGER_MODULUS_H
+#define BIG_INTEGER_MODULUS_H
+
+#include <cstdint>
+#include "big_integer.h"
+
+// Barrett reduction by a fixed modulus. The reciprocal is computed once by
+// Newton iteration, after that every reduction costs two multiplications.
+struct big_integer_modulus {
+	explicit big_integer_modulus(big_integer const &modulus);
+
+	big_integer const &modulus() const;
+
+	// the same as a % modulus
+	big_integer reduce(big_integer const &a) const;
+
+ private:
+	static uint32_t bit_length(big_integer const &a);
+
+	big_integer mod;
+	big_integer reciprocal;
+	big_integer::storage_t padded_mod;
+	uint32_t bits;
+};
+
+#endif // BIG_INTEGER_MODULUS_H
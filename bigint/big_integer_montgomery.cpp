@@ -0,0 +1,190 @@
+#include "big_integer_montgomery.h"
+#include "big_integer_modulus.h"
+#include "big_integer_arena.h"
+#include <algorithm>
+#include <stdexcept>
+
+namespace {
+	using storage_t = big_integer::storage_t;
+
+	bool test_bit(storage_t const &a, size_t index) {
+		return (a[index / kernels::limb_bits] >> (index % kernels::limb_bits)) & 1u;
+	}
+
+	size_t bit_length(storage_t const &a) {
+		return kernels::limb_bits * a.size() - __builtin_clzll(a.back());
+	}
+
+	// sliding window width for an exponent of the given length
+	size_t window_bits(size_t exp_bits) {
+		return exp_bits > 671 ? 6 : exp_bits > 239 ? 5 : exp_bits > 79 ? 4 : exp_bits > 23 ? 3 : exp_bits > 7 ? 2 : 1;
+	}
+}
+
+big_integer_montgomery::big_integer_montgomery(big_integer const &modulus) : mod(modulus) {
+	mod.sign = true;
+
+	if ((mod.dig[0] & 1u) == 0) {
+		throw std::invalid_argument("montgomery modulus must be odd");
+	}
+
+	// Newton iteration for the inverse modulo 2^limb_bits, every step
+	// doubles the number of correct low bits starting from 3
+	limb_t inverse = mod.dig[0];
+
+	for (size_t bits = 3; bits < kernels::limb_bits; bits *= 2) {
+		inverse *= 2 - mod.dig[0] * inverse;
+	}
+
+	m_inv = 0 - inverse;
+	r2 = reduced(big_integer(1) << static_cast<uint32_t>(2 * kernels::limb_bits * size()));
+}
+
+big_integer const &big_integer_montgomery::modulus() const {
+	return mod;
+}
+
+size_t big_integer_montgomery::size() const {
+	return mod.size();
+}
+
+// a mod m in [0, m), padded to size() limbs
+big_integer::storage_t big_integer_montgomery::reduced(big_integer const &a) const {
+	big_integer x = a % mod;
+
+	if (!x.sign) {
+		x += mod;
+	}
+
+	storage_t result(size());
+	std::copy(x.dig.begin(), x.dig.end(), result.data());
+	return result;
+}
+
+void big_integer_montgomery::multiply(limb_t *r, limb_t const *a, limb_t const *b, limb_t *product) const {
+	kernels::mul(product, a, size(), b, size());
+	kernels::redc(r, product, mod.dig.data(), size(), m_inv);
+}
+
+big_integer big_integer_montgomery::to_montgomery(big_integer const &a) const {
+	storage_t x = reduced(a), result(size());
+	kernels::scratch_buffer<limb_t> product(2 * size());
+	multiply(result.data(), x.data(), r2.data(), product.data());
+	return big_integer(true, std::move(result));
+}
+
+big_integer big_integer_montgomery::from_montgomery(big_integer const &a) const {
+	storage_t x = reduced(a), result(size());
+	kernels::scratch_buffer<limb_t> product(2 * size());
+	std::copy(x.begin(), x.end(), product.data());
+	kernels::redc(result.data(), product.data(), mod.dig.data(), size(), m_inv);
+	return big_integer(true, std::move(result));
+}
+
+big_integer big_integer_montgomery::multiply(big_integer const &a, big_integer const &b) const {
+	storage_t x = reduced(a), y = reduced(b), result(size());
+	kernels::scratch_buffer<limb_t> product(2 * size());
+	multiply(result.data(), x.data(), y.data(), product.data());
+	return big_integer(true, std::move(result));
+}
+
+big_integer big_integer_montgomery::pow(big_integer const &base, big_integer const &exp) const {
+	if (!exp.sign) {
+		throw std::invalid_argument("negative exponent");
+	} else if (exp.is_zero()) {
+		return big_integer(1) % mod;
+	}
+
+	size_t const n = size();
+	size_t const exp_bits = bit_length(exp.dig);
+	size_t const window = window_bits(exp_bits);
+
+	// table[k] = base^(2k + 1), all buffers are allocated once up front
+	kernels::scratch_buffer<limb_t> table(n << (window - 1)), product(2 * n), square(n);
+	storage_t result(n);
+	storage_t x = reduced(base);
+	limb_t *powers = table.data();
+
+	multiply(powers, x.data(), r2.data(), product.data());
+
+	if (window > 1) {
+		multiply(square.data(), powers, powers, product.data());
+
+		for (size_t k = 1; k < (size_t(1) << (window - 1)); k++) {
+			multiply(powers + k * n, powers + (k - 1) * n, square.data(), product.data());
+		}
+	}
+
+	// the top bit of the exponent is set, so the first window starts the result
+	bool started = false;
+
+	for (size_t i = exp_bits; i > 0;) {
+		if (!test_bit(exp.dig, i - 1)) {
+			multiply(result.data(), result.data(), result.data(), product.data());
+			i--;
+			continue;
+		}
+
+		size_t low = i > window ? i - window : 0;
+
+		while (!test_bit(exp.dig, low)) {
+			low++;
+		}
+
+		size_t value = 0;
+
+		for (size_t bit = i; bit > low; bit--) {
+			value = 2 * value + test_bit(exp.dig, bit - 1);
+		}
+
+		limb_t const *power = powers + (value >> 1u) * n;
+
+		if (started) {
+			for (size_t bit = low; bit < i; bit++) {
+				multiply(result.data(), result.data(), result.data(), product.data());
+			}
+
+			multiply(result.data(), result.data(), power, product.data());
+		} else {
+			std::copy(power, power + n, result.data());
+			started = true;
+		}
+
+		i = low;
+	}
+
+	std::fill(product.begin(), product.end(), 0);
+	std::copy(result.begin(), result.end(), product.begin());
+	kernels::redc(result.data(), product.data(), mod.dig.data(), n, m_inv);
+	return big_integer(true, std::move(result));
+}
+
+big_integer powmod(big_integer const &base, big_integer const &exp, big_integer const &mod) {
+	if (mod.is_zero()) {
+		throw std::range_error("division by zero");
+	} else if (mod.dig[0] & 1u) {
+		return big_integer_montgomery(mod).pow(base, exp);
+	} else if (!exp.sign) {
+		throw std::invalid_argument("negative exponent");
+	}
+
+	// even modulus, plain square and multiply with Barrett reduction
+	big_integer_modulus modulus(mod);
+	big_integer b = modulus.reduce(base);
+
+	if (!b.sign) {
+		b += modulus.modulus();
+	}
+
+	big_integer result = big_integer(1) % modulus.modulus();
+
+	for (size_t i = exp.is_zero() ? 0 : bit_length(exp.dig); i > 0; i--) {
+		result = modulus.reduce(result * result);
+
+		if (test_bit(exp.dig, i - 1)) {
+			result = modulus.reduce(result * b);
+		}
+	}
+
+	return result;
+}
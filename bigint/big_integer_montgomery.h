@@ -0,0 +1,38 @@
+#ifndef BIG_INTEGER_MONTGOMERY_H
+#define BIG_INTEGER_MONTGOMERY_H
+
+#include "big_integer.h"
+
+// Arithmetic modulo a fixed odd number in Montgomery form, where x stands
+// for x * R mod m with R = 2^(limb_bits * size of m).
+struct big_integer_montgomery {
+	using limb_t = big_integer::limb_t;
+
+	explicit big_integer_montgomery(big_integer const &modulus);
+
+	big_integer const &modulus() const;
+
+	big_integer to_montgomery(big_integer const &a) const;
+	big_integer from_montgomery(big_integer const &a) const;
+
+	// a * b / R mod m for a and b in Montgomery form
+	big_integer multiply(big_integer const &a, big_integer const &b) const;
+
+	// base^exp mod m, arguments and result in the usual form
+	big_integer pow(big_integer const &base, big_integer const &exp) const;
+
+ private:
+	// r = a * b / R mod m over size() limbs, product holds 2 * size() limbs
+	void multiply(limb_t *r, limb_t const *a, limb_t const *b, limb_t *product) const;
+	big_integer::storage_t reduced(big_integer const &a) const;
+	size_t size() const;
+
+	big_integer mod;
+	big_integer::storage_t r2;
+	limb_t m_inv;
+};
+
+// base^exp mod |mod| in the range [0, |mod|), exp must be non-negative
+big_integer powmod(big_integer const &base, big_integer const &exp, big_integer const &mod);
+
+#endif // BIG_INTEGER_MONTGOMERY_H
@@ -0,0 +1,178 @@
+#include "big_integer_kernels.h"
+#include "big_integer_arena.h"
+#include "big_integer_parallel.h"
+#include <algorithm>
+
+// Three-prime number theoretic transform. Every limb is split into two 32-bit
+// coefficients, the convolution is computed modulo three primes below 2^31 and
+// recovered by CRT. The product of the primes exceeds 2^89, which bounds any
+// coefficient of a convolution of two sequences of 32-bit numbers up to 2^24
+// (twice ntt_max_size) long.
+namespace kernels {
+	size_t ntt_threshold = 32768;
+
+	namespace {
+		using uint128_t = unsigned int __attribute__((mode(TI)));
+
+		template<uint32_t MOD, uint32_t ROOT>
+		struct ntt_prime {
+			static uint32_t mul(uint32_t a, uint32_t b) {
+				return static_cast<uint32_t>(static_cast<uint64_t>(a) * b % MOD);
+			}
+
+			static uint32_t pow(uint32_t a, uint64_t e) {
+				uint32_t result = 1;
+
+				for (; e > 0; e >>= 1u) {
+					if (e & 1u) {
+						result = mul(result, a);
+					}
+
+					a = mul(a, a);
+				}
+
+				return result;
+			}
+
+			static uint32_t inverse(uint32_t a) {
+				return pow(a, MOD - 2);
+			}
+
+			static void transform(uint32_t *a, size_t n, bool invert) {
+
+				for (size_t i = 1, j = 0; i < n; i++) {
+					size_t bit = n >> 1u;
+
+					for (; j & bit; bit >>= 1u) {
+						j ^= bit;
+					}
+
+					j ^= bit;
+
+					if (i < j) {
+						std::swap(a[i], a[j]);
+					}
+				}
+
+				uint32_t w = pow(ROOT, (MOD - 1) / n);
+
+				if (invert) {
+					w = inverse(w);
+				}
+
+				scratch_buffer<uint32_t> roots(std::max<size_t>(n / 2, 1));
+				roots[0] = 1;
+
+				for (size_t i = 1; i < roots.size(); i++) {
+					roots[i] = mul(roots[i - 1], w);
+				}
+
+				for (size_t len = 2; len <= n; len <<= 1u) {
+					size_t half = len / 2;
+					size_t step = n / len;
+
+					for (size_t i = 0; i < n; i += len) {
+						for (size_t j = 0; j < half; j++) {
+							uint32_t u = a[i + j];
+							uint32_t v = mul(a[i + j + half], roots[j * step]);
+
+							a[i + j] = u + v >= MOD ? u + v - MOD : u + v;
+							a[i + j + half] = u >= v ? u - v : u + MOD - v;
+						}
+					}
+				}
+
+				if (invert) {
+					uint32_t n_inv = inverse(static_cast<uint32_t>(n % MOD));
+
+					for (size_t i = 0; i < n; i++) {
+						a[i] = mul(a[i], n_inv);
+					}
+				}
+			}
+
+			// the 32-bit halves of a[0..n), result must be zero beyond them
+			static void load(uint32_t *result, limb_t const *a, size_t n) {
+				for (size_t i = 0; i < n; i++) {
+					result[2 * i] = static_cast<uint32_t>(a[i]) % MOD;
+					result[2 * i + 1] = static_cast<uint32_t>(a[i] >> 32u) % MOD;
+				}
+			}
+
+			// fa[0..size) = a * b mod MOD, fa must be zero
+			static void convolve(uint32_t *fa, limb_t const *a, size_t n, limb_t const *b, size_t m, size_t size) {
+				bool square = a == b && n == m;
+				scratch_buffer<uint32_t> fb(square ? 0 : size);
+
+				parallel_for(square ? 1 : 2, m, [&](size_t i) {
+					uint32_t *f = i == 0 ? fa : fb.data();
+					load(f, i == 0 ? a : b, i == 0 ? n : m);
+					transform(f, size, false);
+				});
+
+				if (square) {
+					for (size_t i = 0; i < size; i++) {
+						fa[i] = mul(fa[i], fa[i]);
+					}
+				} else {
+					for (size_t i = 0; i < size; i++) {
+						fa[i] = mul(fa[i], fb[i]);
+					}
+				}
+
+				transform(fa, size, true);
+			}
+		};
+
+		using prime1 = ntt_prime<2013265921u, 31u>;
+		using prime2 = ntt_prime<469762049u, 3u>;
+		using prime3 = ntt_prime<754974721u, 11u>;
+	}
+
+	void mul_ntt(limb_t *r, limb_t const *a, size_t n, limb_t const *b, size_t m) {
+		size_t size = 1;
+
+		while (size < 2 * (n + m)) {
+			size <<= 1u;
+		}
+
+		scratch_buffer<uint32_t> c(3 * size);
+		uint32_t *c1 = c.data(), *c2 = c1 + size, *c3 = c2 + size;
+
+		parallel_for(3, m, [&](size_t i) {
+			if (i == 0) {
+				prime1::convolve(c1, a, n, b, m, size);
+			} else if (i == 1) {
+				prime2::convolve(c2, a, n, b, m, size);
+			} else {
+				prime3::convolve(c3, a, n, b, m, size);
+			}
+		});
+
+		uint64_t const p1 = 2013265921u;
+		uint64_t const p2 = 469762049u;
+		uint64_t const p3 = 754974721u;
+
+		uint32_t const p1_inv_mod_p2 = prime2::inverse(p1 % p2);
+		uint32_t const p1p2_inv_mod_p3 = prime3::inverse(p1 * p2 % p3);
+
+		uint128_t carry = 0;
+
+		for (size_t i = 0; i < 2 * (n + m); i++) {
+			uint64_t x1 = c1[i];
+			uint64_t x2 = prime2::mul(static_cast<uint32_t>((c2[i] + p2 - x1 % p2) % p2), p1_inv_mod_p2);
+			uint64_t t = (x1 + x2 * p1) % p3;
+			uint64_t x3 = prime3::mul(static_cast<uint32_t>((c3[i] + p3 - t) % p3), p1p2_inv_mod_p3);
+
+			carry += x1 + static_cast<uint128_t>(x2) * p1 + static_cast<uint128_t>(x3) * (p1 * p2);
+			limb_t half = static_cast<uint32_t>(carry);
+			carry >>= 32u;
+
+			if (i % 2 == 0) {
+				r[i / 2] = half;
+			} else {
+				r[i / 2] |= half << 32u;
+			}
+		}
+	}
+}
@@ -0,0 +1,239 @@
+#include "big_integer_parallel.h"
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace kernels {
+	size_t parallel_threshold = 2048;
+
+	namespace {
+		struct fork_state {
+			std::function<void(size_t)> const *body;
+			std::atomic<size_t> pending;
+			std::mutex error_mutex;
+			std::exception_ptr error;
+		};
+
+		struct task {
+			fork_state *fork;
+			size_t index;
+		};
+
+		struct task_queue {
+			std::mutex mutex;
+			std::deque<task> tasks;
+		};
+
+		// Every worker owns a queue, one more is shared by the threads outside
+		// the pool. Forks are pushed to the back of the forking thread's queue and
+		// popped from there, idle threads steal from the front of the others.
+		class thread_pool {
+		public:
+			explicit thread_pool(size_t workers) : queues(workers + 1) {
+				for (size_t i = 0; i < workers; i++) {
+					threads.emplace_back([this, i] { work(i); });
+				}
+			}
+
+			~thread_pool() {
+				{
+					std::lock_guard<std::mutex> lock(mutex);
+					stop = true;
+				}
+
+				wake.notify_all();
+
+				for (std::thread &thread : threads) {
+					thread.join();
+				}
+			}
+
+			void parallel_for(size_t count, std::function<void(size_t)> const &body) {
+				fork_state state;
+				state.body = &body;
+				state.pending = count;
+
+				size_t self = own_queue();
+				push(self, &state, count);
+				run({&state, 0});
+
+				// help with queued tasks, sleep while there are none and the
+				// fork is still running elsewhere
+				while (state.pending.load(std::memory_order_acquire) != 0) {
+					task t;
+
+					if (pop(self, t)) {
+						run(t);
+						continue;
+					}
+
+					std::unique_lock<std::mutex> lock(mutex);
+					wake.wait(lock, [&] {
+						return state.pending.load(std::memory_order_acquire) == 0 || queued > 0;
+					});
+				}
+
+				if (state.error) {
+					std::rethrow_exception(state.error);
+				}
+			}
+
+		private:
+			size_t own_queue() const;
+
+			// Queues tasks 1..count of fork. queued only changes under the lock
+			// of the deque it counts, so it never drops below the tasks left,
+			// and the increment is also under mutex, so no sleeper misses it.
+			void push(size_t self, fork_state *fork, size_t count) {
+				{
+					std::lock_guard<std::mutex> lock(mutex);
+					std::lock_guard<std::mutex> queue_lock(queues[self].mutex);
+
+					for (size_t i = 1; i < count; i++) {
+						queues[self].tasks.push_back({fork, i});
+					}
+
+					queued += count - 1;
+				}
+
+				wake.notify_all();
+			}
+
+			bool pop(size_t self, task &t) {
+				for (size_t i = 0; i < queues.size(); i++) {
+					task_queue &queue = queues[(self + i) % queues.size()];
+					std::lock_guard<std::mutex> lock(queue.mutex);
+
+					if (queue.tasks.empty()) {
+						continue;
+					}
+
+					if (i == 0) {
+						t = queue.tasks.back();
+						queue.tasks.pop_back();
+					} else {
+						t = queue.tasks.front();
+						queue.tasks.pop_front();
+					}
+
+					queued--;
+					return true;
+				}
+
+				return false;
+			}
+
+			// the fork may be gone as soon as pending drops, the last task wakes
+			// the thread waiting for it
+			void run(task const &t) {
+				fork_state &fork = *t.fork;
+
+				try {
+					(*fork.body)(t.index);
+				} catch (...) {
+					std::lock_guard<std::mutex> lock(fork.error_mutex);
+
+					if (!fork.error) {
+						fork.error = std::current_exception();
+					}
+				}
+
+				if (fork.pending.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+					{
+						std::lock_guard<std::mutex> lock(mutex);
+					}
+
+					wake.notify_all();
+				}
+			}
+
+			void work(size_t self);
+
+			std::vector<task_queue> queues;
+			std::vector<std::thread> threads;
+			std::mutex mutex;
+			std::condition_variable wake;
+			std::atomic<size_t> queued{0};
+			bool stop = false;
+		};
+
+		thread_local thread_pool const *current_pool = nullptr;
+		thread_local size_t current_queue = 0;
+
+		size_t thread_pool::own_queue() const {
+			return current_pool == this ? current_queue : queues.size() - 1;
+		}
+
+		void thread_pool::work(size_t self) {
+			current_pool = this;
+			current_queue = self;
+
+			for (;;) {
+				task t;
+
+				if (pop(self, t)) {
+					run(t);
+					continue;
+				}
+
+				std::unique_lock<std::mutex> lock(mutex);
+				wake.wait(lock, [this] { return stop || queued > 0; });
+
+				if (stop) {
+					return;
+				}
+			}
+		}
+
+		std::mutex pool_mutex;
+		size_t threads = 0;
+		std::unique_ptr<thread_pool> pool;
+
+		size_t current_thread_count() {
+			if (threads == 0) {
+				threads = std::max<size_t>(std::thread::hardware_concurrency(), 1);
+			}
+
+			return threads;
+		}
+
+		thread_pool *shared_pool() {
+			std::lock_guard<std::mutex> lock(pool_mutex);
+
+			if (!pool && current_thread_count() > 1) {
+				pool.reset(new thread_pool(threads - 1));
+			}
+
+			return pool.get();
+		}
+	}
+
+	size_t thread_count() {
+		std::lock_guard<std::mutex> lock(pool_mutex);
+		return current_thread_count();
+	}
+
+	void set_thread_count(size_t count) {
+		std::lock_guard<std::mutex> lock(pool_mutex);
+		threads = std::max<size_t>(count, 1);
+		pool.reset();
+	}
+
+	void parallel_for(size_t count, std::function<void(size_t)> const &body) {
+		thread_pool *workers = count > 1 ? shared_pool() : nullptr;
+
+		if (workers == nullptr) {
+			for (size_t i = 0; i < count; i++) {
+				body(i);
+			}
+		} else {
+			workers->parallel_for(count, body);
+		}
+	}
+}
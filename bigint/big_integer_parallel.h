@@ -0,0 +1,29 @@
+#ifndef BIG_INTEGER_PARALLEL_H
+#define BIG_INTEGER_PARALLEL_H
+
+#include "big_integer_kernels.h"
+#include <functional>
+
+// Fork-join over a work-stealing pool of thread_count() - 1 workers. A thread
+// waiting for its tasks runs queued ones meanwhile, so tasks may fork again.
+namespace kernels {
+	// Calls body(0), ..., body(count - 1), on the workers as far as they are
+	// free, and returns once all of them are finished. The first exception
+	// thrown by body is rethrown.
+	void parallel_for(size_t count, std::function<void(size_t)> const &body);
+
+	// The same for work on operands of the given size in limbs, serially
+	// below parallel_threshold where a task would not pay for itself.
+	template<typename F>
+	void parallel_for(size_t count, size_t limbs, F const &body) {
+		if (limbs >= parallel_threshold) {
+			parallel_for(count, body);
+		} else {
+			for (size_t i = 0; i < count; i++) {
+				body(i);
+			}
+		}
+	}
+}
+
+#endif // BIG_INTEGER_PARALLEL_H
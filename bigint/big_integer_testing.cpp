@@ -1,13 +1,18 @@
 #include <algorithm>
+#include <atomic>
 #include <cassert>
 #include <cstdlib>
+#include <memory_resource>
 #include <random>
 #include <vector>
 #include <utility>
 #include <gtest/gtest.h>
 
 #include "big_integer.h"
+#include "big_integer_arena.h"
 #include "big_integer_gmp.h"
+#include "big_integer_modulus.h"
+#include "big_integer_montgomery.h"
 
 TEST(correctness, two_plus_two) {
   EXPECT_EQ(big_integer(4), big_integer(2) + big_integer(2));
@@ -150,6 +155,14 @@ TEST(correctness, sub_signed) {
   EXPECT_TRUE(a == 85);
 }
 
+TEST(correctness, sub_to_zero) {
+  big_integer a = 7;
+
+  a -= 7;
+  EXPECT_EQ("0", to_string(a));
+  EXPECT_EQ("0", to_string(-a));
+}
+
 TEST(correctness, sub_return_value) {
   big_integer a = 5;
   big_integer b = 1;
@@ -368,6 +381,17 @@ TEST(correctness, xor_signed) {
   EXPECT_TRUE((a ^ (b - 256)) == (0x66 - 256));
 }
 
+TEST(correctness, bitwise_long_signed) {
+  big_integer a = -(big_integer(1) << 128) + 1;
+  big_integer b = -(big_integer(1) << 64) + 2;
+
+  EXPECT_EQ(-(big_integer(1) << 128), a & b);
+  EXPECT_EQ(-(big_integer(1) << 64) + 3, a | b);
+  EXPECT_EQ((big_integer(1) << 128) - (big_integer(1) << 64) + 3, a ^ b);
+  EXPECT_EQ(a, a & a);
+  EXPECT_EQ(0, a ^ a);
+}
+
 TEST(correctness, xor_return_value) {
   big_integer a = 1;
 
@@ -382,6 +406,17 @@ TEST(correctness, not_) {
   EXPECT_TRUE(~a == (-a - 1));
 }
 
+TEST(correctness, not_carries) {
+  big_integer max = (big_integer(1) << 128) - 1;
+  EXPECT_EQ(-1, ~big_integer(0));
+  EXPECT_EQ(0, ~big_integer(-1));
+  EXPECT_EQ(-(big_integer(1) << 128), ~max);
+  EXPECT_EQ(max, ~-(big_integer(1) << 128));
+  EXPECT_EQ(max, ~~max);
+  EXPECT_FALSE((~big_integer(0)).positive());
+  EXPECT_TRUE((~big_integer(-1)).positive());
+}
+
 TEST(correctness, shl_) {
   big_integer a = 23;
 
@@ -422,6 +457,13 @@ TEST(correctness, shr_signed) {
   EXPECT_EQ(-155, a);
 }
 
+TEST(correctness, shr_signed_exact) {
+  EXPECT_EQ(-46786, big_integer(-93572) >> 1);
+  EXPECT_EQ(-(big_integer(1) << 136), -(big_integer(1) << 200) >> 64);
+  EXPECT_EQ(-(big_integer(1) << 136) - 1, (-(big_integer(1) << 200) - 1) >> 64);
+  EXPECT_EQ(-1, big_integer(-5) >> 1000);
+}
+
 TEST(correctness, shr_return_value) {
   big_integer a = 64;
 
@@ -577,6 +619,229 @@ TEST(correctness, string_conv) {
   EXPECT_EQ("-2147483649", to_string(lim));
 }
 
+TEST(correctness, string_conv_powers_of_ten) {
+  big_integer a = 1;
+  std::string expected = "1";
+  for (size_t i = 0; i != 1000; ++i) {
+    a *= 10;
+    expected += '0';
+
+    EXPECT_EQ(expected, to_string(a));
+    EXPECT_EQ('-' + expected, to_string(-a));
+    EXPECT_EQ(std::string(i + 1, '9'), to_string(a - 1));
+    EXPECT_EQ(a, big_integer(expected));
+    EXPECT_EQ(-a, big_integer('-' + expected));
+    EXPECT_EQ(a - 1, big_integer(std::string(i + 1, '9')));
+  }
+}
+
+TEST(correctness, string_view_ctor) {
+  std::string s = "x-123456789012345678901234567890y";
+  std::string_view digits = std::string_view(s).substr(1, 31);
+
+  EXPECT_EQ(big_integer("-123456789012345678901234567890"), big_integer(digits));
+  EXPECT_THROW(big_integer(std::string_view(s).substr(1)), std::runtime_error);
+  EXPECT_THROW(big_integer(std::string_view()), std::length_error);
+}
+
+namespace {
+// multiplication may allocate on worker threads
+std::atomic<size_t> allocations{0};
+}
+
+// kept out of line, otherwise gcc pairs malloc() with operator delete
+// at inlined call sites and warns about mismatched deallocation
+__attribute__((noinline)) void* operator new(size_t size) {
+  ++allocations;
+  if (void* p = std::malloc(size))
+    return p;
+  throw std::bad_alloc();
+}
+
+__attribute__((noinline)) void operator delete(void* p) noexcept {
+  std::free(p);
+}
+
+__attribute__((noinline)) void operator delete(void* p, size_t) noexcept {
+  std::free(p);
+}
+
+TEST(correctness, small_values_do_not_allocate) {
+  size_t before = allocations;
+
+  big_integer a = 12345;
+  big_integer b = -678;
+  for (int i = 0; i != 100; ++i) {
+    a += b;
+    a *= 7;
+    a %= 1000003;
+    b = a - b;
+    b /= 3;
+    a ^= b;
+    a = (a << 3) >> 2;
+  }
+
+  EXPECT_EQ(before, allocations);
+}
+
+TEST(correctness, scratch_space_is_reused) {
+  std::default_random_engine rng(5);
+  big_integer_gmp ga, gb;
+  ga.random(20000, rng);
+  gb.random(9000, rng);
+  big_integer a(to_string(ga)), b(to_string(gb));
+
+  // the first round grows the arena, afterwards only the product, the
+  // quotient and the remainder allocate
+  big_integer product = a * b, quotient = a / b;
+  size_t before = allocations;
+  for (int i = 0; i != 10; ++i) {
+    product = a * b;
+    quotient = a / b;
+  }
+  EXPECT_EQ(10u * 3, allocations - before);
+  EXPECT_EQ(to_string(ga * gb), to_string(product));
+  EXPECT_EQ(to_string(ga / gb), to_string(quotient));
+}
+
+TEST(correctness, scoped_arena) {
+  big_integer a = (big_integer(1) << 50000) - 1;
+  kernels::scratch_arena arena;
+  {
+    kernels::scoped_arena scope(arena);
+    EXPECT_EQ(&arena, &kernels::current_arena());
+    EXPECT_EQ((big_integer(1) << 100000) - (big_integer(1) << 50001) + 1, a * a);
+  }
+  EXPECT_NE(&arena, &kernels::current_arena());
+  EXPECT_GT(arena.capacity(), 0u);
+}
+
+TEST(correctness, copies_share_digits) {
+  big_integer a = big_integer(1) << 10000;
+
+  size_t before = allocations;
+  big_integer b = a;
+  big_integer c;
+  c = b;
+  EXPECT_EQ(before, allocations);
+
+  c += 1;
+  b <<= 1;
+  EXPECT_EQ(a + 1, c);
+  EXPECT_EQ(a * 2, b);
+  EXPECT_EQ(big_integer(1) << 10000, a);
+}
+
+namespace {
+// distinct objects which all compare equal, memory comes from the heap
+struct heap_resource : std::pmr::memory_resource {
+  void* do_allocate(size_t bytes, size_t alignment) override {
+    return std::pmr::new_delete_resource()->allocate(bytes, alignment);
+  }
+
+  void do_deallocate(void* p, size_t bytes, size_t alignment) override {
+    std::pmr::new_delete_resource()->deallocate(p, bytes, alignment);
+  }
+
+  bool do_is_equal(std::pmr::memory_resource const& other) const noexcept override {
+    return dynamic_cast<heap_resource const*>(&other) != nullptr;
+  }
+};
+}
+
+TEST(correctness, storage_equal_resources) {
+  using storage_t = big_integer::storage_t;
+  heap_resource first, second;
+  storage_t a(100, 1, &first), b(3, 2, &second);
+
+  b = std::move(a);
+  EXPECT_EQ(&first, a.resource());
+  EXPECT_EQ(&second, b.resource());
+  EXPECT_EQ(100u, b.size());
+  EXPECT_EQ(1u, b[99]);
+
+  // equal resources share the buffer
+  storage_t c(b, &first);
+  EXPECT_TRUE(b.is_shared());
+  EXPECT_EQ(&first, c.resource());
+}
+
+TEST(correctness, memory_resource) {
+  big_integer copy;
+  {
+    unsigned char buffer[1 << 14];
+    std::pmr::monotonic_buffer_resource pool(buffer, sizeof buffer, std::pmr::null_memory_resource());
+    big_integer a(&pool), b(&pool);
+
+    // results of operators are copied into the pool on assignment
+    a = big_integer(1) << 1000;
+    b = a - 1;
+    a *= b;
+    EXPECT_EQ(&pool, a.resource());
+    EXPECT_EQ(&pool, b.resource());
+    EXPECT_EQ((big_integer(1) << 2000) - (big_integer(1) << 1000), a);
+
+    size_t before = allocations;
+    a <<= 3000;
+    b |= a;
+    a += b;
+    EXPECT_EQ(before, allocations);
+
+    copy = a;
+    EXPECT_EQ(std::pmr::new_delete_resource(), copy.resource());
+    EXPECT_EQ(&pool, big_integer(a, &pool).resource());
+
+    // a moved-from number stays on its resource
+    big_integer moved(std::move(a));
+    EXPECT_EQ(&pool, moved.resource());
+    EXPECT_EQ(&pool, a.resource());
+    a = big_integer(1) << 2000;
+    EXPECT_EQ(&pool, a.resource());
+    EXPECT_EQ(big_integer(1) << 2000, a);
+  }
+
+  big_integer expected = (big_integer(1) << 5000) - (big_integer(1) << 4000);
+  EXPECT_EQ(expected + (expected | ((big_integer(1) << 1000) - 1)), copy);
+}
+
+TEST(correctness, move_leaves_zero) {
+  big_integer a = big_integer(1) << 10000;
+  big_integer b = std::move(a);
+  EXPECT_EQ(a, 0);
+  EXPECT_EQ(b, big_integer(1) << 10000);
+
+  a = std::move(b);
+  EXPECT_EQ(a, big_integer(1) << 10000);
+  EXPECT_EQ(b, 0);
+
+  big_integer x = 5, y = -7;
+  y = std::move(x);
+  EXPECT_EQ(y, 5);
+  EXPECT_EQ(x, 0);
+  EXPECT_TRUE(x.positive());
+
+  y = std::move(y);
+  EXPECT_EQ(y, 5);
+
+  // each side keeps its own resource, whether the digits are taken or copied
+  heap_resource first, second;
+  std::pmr::unsynchronized_pool_resource pool;
+  big_integer p(big_integer(1) << 1000, &first), q(&second), r(&pool);
+  q = std::move(p);
+  EXPECT_EQ(q, big_integer(1) << 1000);
+  EXPECT_EQ(p, 0);
+  EXPECT_EQ(&first, p.resource());
+  EXPECT_EQ(&second, q.resource());
+  r = std::move(q);
+  EXPECT_EQ(r, big_integer(1) << 1000);
+  EXPECT_EQ(q, 0);
+  EXPECT_EQ(&second, q.resource());
+  EXPECT_EQ(&pool, r.resource());
+
+  big_integer c = (big_integer(1) << 100) - (big_integer(1) << 200) * 3 + big_integer(5) * (big_integer(7) << 300);
+  EXPECT_EQ(c, big_integer("71296259171707013019395599094323414822668616807481142885987893507246379110964837834616209408"));
+}
+
 namespace {
 size_t const number_of_iterations = 10;
 size_t const max_size = 2048;
@@ -708,6 +973,18 @@ TEST(correctness_random, cmp) {
   }
 }
 
+TEST(correctness_random, cmp_long) {
+  big_integer a = (big_integer(1) << 2000) - 1;
+
+  for (uint32_t bit = 0; bit < 2000; bit += 61) {
+    big_integer b = a ^ (big_integer(1) << bit);
+    EXPECT_LT(b, a);
+    EXPECT_GT(-b, -a);
+    EXPECT_NE(a, b);
+    EXPECT_EQ(a, b | a);
+  }
+}
+
 TEST(correctness_random, add) {
   std::default_random_engine rng(42);
   for (size_t itn = 0; itn != number_of_iterations; ++itn) {
@@ -744,6 +1021,143 @@ TEST(correctness_random, mul) {
   }
 }
 
+TEST(correctness_random, mul_large) {
+  std::default_random_engine rng(42);
+  size_t const sizes[] = {1000, 12000, 40000, 100000};
+  for (size_t a_size : sizes) {
+    for (size_t b_size : sizes) {
+      big_integer_gmp a, b;
+      a.random(a_size, rng);
+      b.random(b_size, rng);
+      big_integer_gmp c = a * b;
+      big_integer R = big_integer(to_string(a)) * big_integer(to_string(b));
+      EXPECT_EQ(to_string(c), to_string(R));
+    }
+  }
+}
+
+TEST(correctness_random, square) {
+  std::default_random_engine rng(42);
+  size_t const sizes[] = {100, 2000, 5000, 15000, 40000};
+  for (size_t size : sizes) {
+    big_integer_gmp a;
+    a.random(size, rng);
+    big_integer A = big_integer(to_string(a));
+    big_integer B = A;
+    B *= B;
+    EXPECT_EQ(to_string(a * a), to_string(A * A));
+    EXPECT_EQ(to_string(a * a), to_string(B));
+  }
+}
+
+TEST(correctness, pow) {
+  EXPECT_EQ(big_integer(1), pow(big_integer(0), 0));
+  EXPECT_EQ(big_integer(0), pow(big_integer(0), 5));
+  EXPECT_EQ(big_integer(-27), pow(big_integer(-3), 3));
+  EXPECT_EQ(big_integer(81), pow(big_integer(-3), 4));
+  EXPECT_EQ(big_integer(1) << 1000, pow(big_integer(2), 1000));
+  EXPECT_EQ(big_integer(1) << 10000, pow(big_integer(1) << 100, 100));
+
+  big_integer base("123456789012345678901234567890");
+  big_integer expected = 1;
+  for (int i = 0; i != 77; ++i)
+    expected *= base;
+  EXPECT_EQ(expected, pow(base, 77));
+}
+
+TEST(correctness, square) {
+  EXPECT_EQ(big_integer(0), square(big_integer(0)));
+  EXPECT_EQ(big_integer(9), square(big_integer(-3)));
+  EXPECT_EQ(big_integer(1) << 20000, square(big_integer(1) << 10000));
+
+  big_integer base("-123456789012345678901234567890");
+  EXPECT_EQ(base * base, square(base));
+
+  std::pmr::unsynchronized_pool_resource pool;
+  big_integer a((big_integer(1) << 5000) - 1, &pool);
+  big_integer b = square(a);
+  EXPECT_EQ(&pool, b.resource());
+  EXPECT_EQ((big_integer(1) << 10000) - (big_integer(1) << 5001) + 1, b);
+}
+
+TEST(correctness_random, mul_huge) {
+  // operands are below the default threshold, lower it to cover the transform
+  size_t const ntt_threshold = kernels::ntt_threshold;
+  kernels::ntt_threshold = 512;
+
+  std::default_random_engine rng(42);
+  big_integer_gmp a, b, c;
+  a.random(200000, rng);
+  b.random(60000, rng);
+  c.random(200000, rng);
+  big_integer A = big_integer(to_string(a));
+  big_integer B = big_integer(to_string(b));
+  big_integer C = big_integer(to_string(c));
+  EXPECT_EQ(to_string(a * b), to_string(A * B));
+  EXPECT_EQ(to_string(a * c), to_string(A * C));
+  EXPECT_EQ(to_string(a * a), to_string(A * A));
+
+  kernels::ntt_threshold = ntt_threshold;
+}
+
+TEST(correctness_random, mul_parallel) {
+  // thresholds low enough that every algorithm forks, several levels deep
+  size_t const ntt_threshold = kernels::ntt_threshold;
+  size_t const parallel_threshold = kernels::parallel_threshold;
+  size_t const thread_count = kernels::thread_count();
+  kernels::ntt_threshold = 1024;
+  kernels::parallel_threshold = 64;
+
+  std::default_random_engine rng(7);
+  for (size_t digits : {3000, 12000, 50000}) {
+    big_integer_gmp a, b, c;
+    a.random(digits, rng);
+    b.random(digits / 3, rng);
+    c.random(digits * 3 / 4, rng);
+    big_integer A = big_integer(to_string(a));
+    big_integer B = big_integer(to_string(b));
+    big_integer C = big_integer(to_string(c));
+
+    kernels::set_thread_count(1);
+    big_integer serial[] = {A * B, A * C, A * A};
+
+    kernels::set_thread_count(4);
+    big_integer parallel[] = {A * B, A * C, A * A};
+
+    EXPECT_EQ(serial[0], parallel[0]);
+    EXPECT_EQ(serial[1], parallel[1]);
+    EXPECT_EQ(serial[2], parallel[2]);
+    EXPECT_EQ(to_string(a * b), to_string(parallel[0]));
+    EXPECT_EQ(to_string(a * c), to_string(parallel[1]));
+    EXPECT_EQ(to_string(a * a), to_string(parallel[2]));
+  }
+
+  kernels::set_thread_count(thread_count);
+  kernels::parallel_threshold = parallel_threshold;
+  kernels::ntt_threshold = ntt_threshold;
+}
+
+TEST(correctness_random, string_conv_parallel) {
+  size_t const parallel_threshold = kernels::parallel_threshold;
+  size_t const thread_count = kernels::thread_count();
+  kernels::parallel_threshold = 16;
+  kernels::set_thread_count(4);
+
+  std::default_random_engine rng(19);
+  for (size_t digits : {1000, 30000, 100000}) {
+    big_integer_gmp a;
+    a.random(digits, rng);
+    std::string expected = to_string(a);
+    big_integer A(expected);
+    EXPECT_EQ(expected, to_string(A));
+    EXPECT_EQ(to_string(a * a), to_string(A * A));
+    EXPECT_EQ(to_string(-a), to_string(big_integer(to_string(-a))));
+  }
+
+  kernels::set_thread_count(thread_count);
+  kernels::parallel_threshold = parallel_threshold;
+}
+
 TEST(correctness_random, div) {
   std::default_random_engine rng(322);
   for (size_t itn = 0; itn != number_of_iterations; ++itn) {
@@ -760,6 +1174,36 @@ TEST(correctness_random, div) {
   }
 }
 
+TEST(correctness_random, div_large) {
+  std::default_random_engine rng(42);
+  size_t const divisor_sizes[] = {5000, 40000, 70000, 119000};
+  for (size_t b_size : divisor_sizes) {
+    big_integer_gmp a, b;
+    a.random(120000, rng);
+    b.random(b_size, rng);
+    big_integer A = big_integer(to_string(a));
+    big_integer B = big_integer(to_string(b));
+    EXPECT_EQ(to_string(a / b), to_string(A / B));
+    EXPECT_EQ(to_string(a % b), to_string(A % B));
+  }
+}
+
+TEST(correctness_random, div_extreme_limbs) {
+  // operands made of all-ones and nearly empty limbs exercise the
+  // quotient digit corrections of the long division
+  for (uint32_t a_bits = 128; a_bits <= 640; a_bits += 64) {
+    for (uint32_t b_bits = 96; b_bits <= a_bits; b_bits += 32) {
+      big_integer_gmp a = (big_integer_gmp(1) << a_bits) - 1;
+      big_integer_gmp b = (big_integer_gmp(1) << b_bits) - (big_integer_gmp(1) << (b_bits / 2));
+      big_integer A = (big_integer(1) << a_bits) - 1;
+      big_integer B = (big_integer(1) << b_bits) - (big_integer(1) << (b_bits / 2));
+      EXPECT_EQ(to_string(a / b), to_string(A / B));
+      EXPECT_EQ(to_string(a % b), to_string(A % B));
+      EXPECT_EQ(to_string(a / (b + 1)), to_string(A / (B + 1)));
+    }
+  }
+}
+
 TEST(correctness_random, mod) {
   std::default_random_engine rng(322);
   for (size_t itn = 0; itn != number_of_iterations; ++itn) {
@@ -776,6 +1220,94 @@ TEST(correctness_random, mod) {
   }
 }
 
+TEST(correctness_random, divmod) {
+  std::default_random_engine rng(322);
+  for (size_t itn = 0; itn != number_of_iterations; ++itn) {
+    big_integer_gmp a, b;
+    a.random(max_size, rng);
+    b.random(itn % 2 ? 40 : max_size / 2, rng);
+    std::pair<big_integer, big_integer> R = divmod(big_integer(to_string(a)), big_integer(to_string(b)));
+    EXPECT_EQ(to_string(a / b), to_string(R.first));
+    EXPECT_EQ(to_string(a % b), to_string(R.second));
+
+    R = divmod(big_integer(to_string(b)), big_integer(to_string(a)));
+    EXPECT_EQ("0", to_string(R.first));
+    EXPECT_EQ(to_string(b), to_string(R.second));
+  }
+}
+
+TEST(correctness_random, barrett_reduce) {
+  std::default_random_engine rng(322);
+  size_t const modulus_sizes[] = {64, 130, 700, 5000, 40000};
+  for (size_t m_size : modulus_sizes) {
+    big_integer_gmp m;
+    m.random(m_size, rng);
+    big_integer_modulus modulus(big_integer(to_string(m)));
+
+    size_t const value_sizes[] = {m_size / 2, m_size + 1, 2 * m_size - 1, 3 * m_size};
+    for (size_t a_size : value_sizes) {
+      big_integer_gmp a;
+      a.random(a_size, rng);
+      EXPECT_EQ(to_string(a % m), to_string(modulus.reduce(big_integer(to_string(a)))));
+    }
+  }
+}
+
+TEST(correctness, powmod_fermat) {
+  // 2^521 - 1 and 2^607 - 1 are prime
+  for (uint32_t p : {521u, 607u}) {
+    big_integer mod = (big_integer(1) << p) - 1;
+    for (int base : {2, 3, -5, 123456789}) {
+      EXPECT_EQ(big_integer(1), powmod(base, mod - 1, mod));
+      EXPECT_EQ((big_integer(base) % mod + mod) % mod, powmod(base, mod, mod));
+    }
+  }
+
+  EXPECT_EQ(big_integer(0), powmod(7, 100, 1));
+  EXPECT_EQ(big_integer(1), powmod(7, 0, 10));
+  EXPECT_EQ(big_integer(1), powmod(-3, 4, 10));
+  EXPECT_EQ(big_integer(4), powmod(2, 1000, 6));
+}
+
+TEST(correctness_random, powmod) {
+  std::default_random_engine rng(322);
+  size_t const sizes[] = {64, 200, 2048, 4096};
+  for (size_t size : sizes) {
+    big_integer_gmp m, b, e;
+    m.random(size, rng);
+    b.random(size + 10, rng);
+    e.random(100, rng);
+    big_integer mod = big_integer(to_string(m));
+    big_integer base = big_integer(to_string(b));
+    big_integer exp = big_integer(to_string(e));
+    if (mod < 0)
+      mod = -mod;
+    if (exp < 0)
+      exp = -exp;
+
+    big_integer expected = 1;
+    for (big_integer i = exp; i > 0; i /= 2) {
+      if (i % 2 != 0)
+        expected = expected * base % mod;
+      base = base * base % mod;
+    }
+    if (expected < 0)
+      expected += mod;
+
+    EXPECT_EQ(expected, powmod(big_integer(to_string(b)), exp, mod));
+    if (mod % 2 != 0) {
+      big_integer_montgomery montgomery(mod);
+      EXPECT_EQ(expected, montgomery.pow(big_integer(to_string(b)), exp));
+      big_integer product = big_integer(to_string(b)) * 3 % mod;
+      if (product < 0)
+        product += mod;
+      big_integer x = montgomery.to_montgomery(big_integer(to_string(b)));
+      big_integer y = montgomery.to_montgomery(3);
+      EXPECT_EQ(product, montgomery.from_montgomery(montgomery.multiply(x, y)));
+    }
+  }
+}
+
 TEST(correctness_random, bitwise) {
   std::default_random_engine rng(42);
   for (size_t itn = 0; itn != number_of_iterations; ++itn) {
@@ -809,6 +1341,93 @@ TEST(correctness_random, bit_shifts) {
   }
 }
 
+TEST(correctness_random, addmul_submul) {
+  std::default_random_engine rng(11);
+  for (size_t itn = 0; itn != number_of_iterations; ++itn) {
+    big_integer_gmp a, b, c;
+    a.random(rng() % max_size + 1, rng);
+    b.random(itn % 2 == 0 ? rng() % 63 + 1 : rng() % max_size + 1, rng);
+    c.random(rng() % (2 * max_size) + 1, rng);
+    big_integer A(to_string(a)), B(to_string(b)), C(to_string(c));
+
+    big_integer R = C;
+    EXPECT_EQ(to_string(c + a * b), to_string(addmul(R, A, B)));
+    R = C;
+    EXPECT_EQ(to_string(c - a * b), to_string(submul(R, A, B)));
+    R = C;
+    EXPECT_EQ(to_string(c - b * a), to_string(submul(R, B, A)));
+    R = A;
+    EXPECT_EQ(to_string(a + a * b), to_string(addmul(R, R, B)));
+    R = A;
+    EXPECT_EQ(to_string(a - a * a), to_string(submul(R, R, R)));
+  }
+}
+
+TEST(correctness_random, or_shifted) {
+  std::default_random_engine rng(12);
+  for (size_t itn = 0; itn != number_of_iterations; ++itn) {
+    big_integer_gmp a, b;
+    a.random(max_size, rng);
+    b.random(max_size, rng);
+    uint32_t shift = rng() % max_size;
+    big_integer A(to_string(a)), B(to_string(b));
+
+    big_integer R = B;
+    EXPECT_EQ(to_string((a << static_cast<int>(shift)) | b), to_string(or_shifted(R, A, shift)));
+  }
+}
+
+TEST(correctness, addmul_reuses_storage) {
+  big_integer x = (big_integer(1) << 3000) - 12345;
+  big_integer coefficients[] = {7, -3, big_integer(1) << 200, 42, -(big_integer(1) << 300)};
+  big_integer powers[] = {1, x, x * x, x * x * x, x * x * x * x};
+
+  big_integer sum;
+  for (size_t i = 0; i != 5; ++i)
+    addmul(sum, coefficients[i], powers[i]);
+
+  // the sum has grown already and the products come from the scratch arena
+  size_t before = allocations;
+  for (size_t i = 0; i != 5; ++i)
+    submul(sum, coefficients[i], powers[i]);
+  EXPECT_EQ(0, sum);
+  for (size_t i = 0; i != 5; ++i)
+    addmul(sum, coefficients[i], powers[i]);
+  EXPECT_EQ(before, allocations);
+
+  big_integer expected = 0;
+  for (size_t i = 5; i != 0; --i)
+    expected = expected * x + coefficients[i - 1];
+  EXPECT_EQ(expected, sum);
+}
+
+TEST(correctness_random, every_kernel_selection) {
+  kernels::cpu_features const detected = kernels::detected_cpu_features();
+
+  for (unsigned subset = 0; subset != 32; ++subset) {
+    kernels::select_kernels({detected.baseline && (subset & 16u),
+                             detected.bmi2 && (subset & 1u), detected.adx && (subset & 2u),
+                             detected.avx2 && (subset & 4u), detected.avx512 && (subset & 8u)});
+
+    std::default_random_engine rng(42);
+    for (size_t itn = 0; itn != number_of_iterations; ++itn) {
+      big_integer_gmp a, b;
+      a.random(max_size, rng);
+      b.random(max_size / 2, rng);
+      big_integer A = big_integer(to_string(a));
+      big_integer B = big_integer(to_string(b));
+      EXPECT_EQ(to_string(a - b), to_string(A - B));
+      EXPECT_EQ(to_string(a * b), to_string(A * B));
+      EXPECT_EQ(to_string(a / b), to_string(A / B));
+      EXPECT_EQ(to_string(a & b), to_string(A & B));
+      EXPECT_EQ(to_string(a ^ -b), to_string(A ^ -B));
+      EXPECT_EQ(a < b, A < B);
+    }
+  }
+
+  kernels::select_kernels(detected);
+}
+
 // TODO: extend due to idea
 TEST(correctness_twos_complement, simple) {
   std::string a = "-36893488147419103232"; // -(1 << 65)
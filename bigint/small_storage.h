@@ -0,0 +1,283 @@
+#ifndef SMALL_STORAGE_H
+#define SMALL_STORAGE_H
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <initializer_list>
+#include <memory_resource>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+// Vector of trivially copyable elements which keeps up to N of them inside
+// the object and allocates memory only when it grows beyond that. Heap
+// buffers are reference counted and shared between copies; a shared buffer
+// is duplicated on the first access that may modify it.
+//
+// Heap buffers come from operator new, or from a std::pmr::memory_resource
+// given at construction and kept for the lifetime of the object as with
+// std::pmr containers: copies use operator new unless given a resource,
+// buffers are shared only between objects with equal resources, and move
+// assignment between unequal resources copies.
+template<typename T, size_t N>
+struct small_storage {
+	static_assert(std::is_trivially_copyable<T>::value, "small_storage holds trivially copyable elements only");
+	static_assert(N * sizeof(T) >= sizeof(void *), "inline buffer must be able to hold a pointer");
+
+	using value_type = T;
+	using iterator = T *;
+	using const_iterator = T const *;
+
+	small_storage() : size_(0), capacity_(N), resource_(nullptr), buffer_() {}
+
+	explicit small_storage(std::pmr::memory_resource *resource) : small_storage() {
+		resource_ = resource == std::pmr::new_delete_resource() ? nullptr : resource;
+	}
+
+	explicit small_storage(size_t count, T const &value = T()) : small_storage() {
+		resize(count, value);
+	}
+
+	small_storage(size_t count, T const &value, std::pmr::memory_resource *resource) : small_storage(resource) {
+		resize(count, value);
+	}
+
+	small_storage(std::initializer_list<T> values) : small_storage() {
+		reserve(values.size());
+		std::copy(values.begin(), values.end(), data());
+		size_ = values.size();
+	}
+
+	small_storage(small_storage const &other) : small_storage() {
+		share(other);
+	}
+
+	small_storage(small_storage const &other, std::pmr::memory_resource *resource) : small_storage(resource) {
+		share(other);
+	}
+
+	// takes the buffer and the resource, other keeps its resource and is left empty
+	small_storage(small_storage &&other) noexcept
+		: size_(other.size_), capacity_(other.capacity_), resource_(other.resource_), buffer_() {
+		std::swap(buffer_, other.buffer_);
+		other.size_ = 0;
+		other.capacity_ = N;
+	}
+
+	~small_storage() {
+		release();
+	}
+
+	small_storage &operator=(small_storage const &other) {
+		if (this != &other) {
+			small_storage copy(other, resource_);
+			swap(copy);
+		}
+
+		return *this;
+	}
+
+	small_storage &operator=(small_storage &&other) {
+		if (same_resource(other)) {
+			swap_contents(other);
+		} else {
+			*this = other;
+		}
+
+		return *this;
+	}
+
+	size_t size() const {
+		return size_;
+	}
+
+	bool empty() const {
+		return size_ == 0;
+	}
+
+	size_t capacity() const {
+		return capacity_;
+	}
+
+	std::pmr::memory_resource *resource() const {
+		return resource_ != nullptr ? resource_ : std::pmr::new_delete_resource();
+	}
+
+	// whether buffers of one can be released through the other
+	bool same_resource(small_storage const &other) const {
+		return resource_ == other.resource_
+		       || (resource_ != nullptr && other.resource_ != nullptr && *resource_ == *other.resource_);
+	}
+
+	bool is_shared() const {
+		return !is_small() && heap_->refs.load(std::memory_order_acquire) > 1;
+	}
+
+	T *data() {
+		unshare();
+		return is_small() ? small_ : heap_->data();
+	}
+
+	T const *data() const {
+		return is_small() ? small_ : heap_->data();
+	}
+
+	T &operator[](size_t index) {
+		return data()[index];
+	}
+
+	T const &operator[](size_t index) const {
+		return data()[index];
+	}
+
+	T &back() {
+		return data()[size_ - 1];
+	}
+
+	T const &back() const {
+		return data()[size_ - 1];
+	}
+
+	iterator begin() {
+		return data();
+	}
+
+	iterator end() {
+		return data() + size_;
+	}
+
+	const_iterator begin() const {
+		return data();
+	}
+
+	const_iterator end() const {
+		return data() + size_;
+	}
+
+	void reserve(size_t new_capacity) {
+		if (new_capacity > capacity_) {
+			reallocate(new_capacity);
+		}
+	}
+
+	void resize(size_t new_size, T const &value = T()) {
+		if (new_size > capacity_) {
+			reserve(std::max(new_size, 2 * capacity_));
+		}
+
+		if (new_size > size_) {
+			std::fill(data() + size_, data() + new_size, value);
+		}
+
+		size_ = new_size;
+	}
+
+	void push_back(T const &value) {
+		if (size_ == capacity_) {
+			reserve(2 * capacity_);
+		}
+
+		data()[size_++] = value;
+	}
+
+	void pop_back() {
+		size_--;
+	}
+
+	void clear() {
+		size_ = 0;
+	}
+
+	// exchanges the resources as well
+	void swap(small_storage &other) noexcept {
+		std::swap(size_, other.size_);
+		std::swap(capacity_, other.capacity_);
+		std::swap(resource_, other.resource_);
+		std::swap(buffer_, other.buffer_);
+	}
+
+ private:
+	// swap without the resources, for storages whose resources compare equal
+	void swap_contents(small_storage &other) noexcept {
+		std::swap(size_, other.size_);
+		std::swap(capacity_, other.capacity_);
+		std::swap(buffer_, other.buffer_);
+	}
+
+	struct block {
+		std::atomic<size_t> refs;
+
+		T *data() {
+			return reinterpret_cast<T *>(this + 1);
+		}
+	};
+
+	static_assert(sizeof(block) % alignof(T) == 0, "elements must be aligned right after the block header");
+
+	bool is_small() const {
+		return capacity_ == N;
+	}
+
+	// requires this to be empty and small
+	void share(small_storage const &other) {
+		if (other.is_small()) {
+			std::copy(other.begin(), other.end(), small_);
+		} else if (same_resource(other)) {
+			heap_ = other.heap_;
+			heap_->refs.fetch_add(1, std::memory_order_relaxed);
+		} else {
+			heap_ = allocate(other.capacity_);
+			std::copy(other.begin(), other.end(), heap_->data());
+		}
+
+		size_ = other.size_;
+		capacity_ = other.capacity_;
+	}
+
+	block *allocate(size_t capacity) {
+		size_t bytes = sizeof(block) + capacity * sizeof(T);
+		void *memory = resource_ == nullptr ? operator new(bytes) : resource_->allocate(bytes, alignof(block));
+		return new(memory) block{{1}};
+	}
+
+	void release() {
+		if (!is_small() && heap_->refs.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+			heap_->~block();
+
+			if (resource_ == nullptr) {
+				operator delete(heap_);
+			} else {
+				resource_->deallocate(heap_, sizeof(block) + capacity_ * sizeof(T), alignof(block));
+			}
+		}
+	}
+
+	void unshare() {
+		if (is_shared()) {
+			reallocate(capacity_);
+		}
+	}
+
+	void reallocate(size_t new_capacity) {
+		block *new_heap = allocate(new_capacity);
+		T const *old_data = static_cast<small_storage const &>(*this).data();
+		std::copy(old_data, old_data + size_, new_heap->data());
+
+		release();
+		heap_ = new_heap;
+		capacity_ = new_capacity;
+	}
+
+	size_t size_;
+	size_t capacity_;
+	std::pmr::memory_resource *resource_; // null for operator new
+
+	union {
+		T small_[N];
+		block *heap_;
+		unsigned char buffer_[N * sizeof(T)];
+	};
+};
+
+#endif // SMALL_STORAGE_H